@@ -15,10 +15,34 @@
 #include <map>
 #include <cmath>
 #include <random>
+#include <cstdint>
+#include <cstdarg>
+#include <cstring>
+#include <cerrno>
+#include <charconv>
+#include <string_view>
+#include <array>
+#include <initializer_list>
+#include <poll.h>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <queue>
+#include <functional>
+#include <csignal>
+#include <sys/ioctl.h>
+#include <stdexcept>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 
 // --- Constants ---
-const int SCREEN_WIDTH = 80; 
-const int SCREEN_HEIGHT = 20; 
+const int SCREEN_WIDTH = 80;  // Playfield size used when the terminal size is unknown
+const int SCREEN_HEIGHT = 20;
+const int MIN_SCREEN_WIDTH = 30;
+const int MIN_SCREEN_HEIGHT = 12;
+const int MAX_SCREEN_WIDTH = 1000;
+const int MAX_SCREEN_HEIGHT = 500;
 const std::string HIGHSCORE_FILE = "highscores.txt";
 const int MAX_LEVEL = 200;
 const int MAX_LIVES = 5;
@@ -31,152 +55,1835 @@ const std::vector<std::string> THEMES = {"Classic", "Dark", "Neon", "Retro", "Fu
 const int MAX_MESSAGES = 10;
 const int BONUS_INTERVAL = 30; // Seconds
 const int CHALLENGE_INTERVAL = 60; // Seconds
-const double GRAVITY_ACCELERATION = 0.5;
+const int BONUS_DURATION = 10; // Seconds
+const int EFFECT_DURATION = 10; // Seconds
+const int POWERUP_DURATION = 5; // Seconds
+const int CHALLENGE_TIME_LIMIT = 60; // Seconds to reach a challenge's target
+const int LEVELS_PER_EXTRA_FRUIT = 5; // Levels it takes for one more fruit to fall at a time
+const double MIN_FRUIT_SPACING = 4.0; // Rows the newest fruit falls before another spawns
+const double GRAVITY_ACCELERATION = 0.5; // Added to a fruit's velocity before its whole part is taken
+const int DEFAULT_TICK_RATE = 60; // Simulation ticks per second
+const int MIN_TICK_RATE = 10;
+const int MAX_TICK_RATE = 1000;
+const std::chrono::milliseconds RULE_STEP(150);         // Cadence of the per-step rules (random effects, particles, magnet)
+const int PARTICLE_LIFETIME_STEPS = 7; // Rule steps a particle lives, about a second
+const std::chrono::milliseconds MAX_TICK_BACKLOG(250);  // Wall time the loop will catch up on after a stall
+const int HEADLESS_MAX_GAME_SECONDS = 3600; // Game time after which a headless game is cut short
+const int HEADLESS_CHUNK = 16;              // Games a batch worker claims at a time
+const int SCORE_HISTOGRAM_BUCKET = 10;      // Points per bucket of the headless score distribution
+const int EFFECT_COUNT = 6;     // One slot per GameEffectType
+const int HUD_STATUS_ROWS = 4;  // Combo, progress, effects and power-up lines below the controls
 
 // --- Enums ---
 enum class FruitType { APPLE, BANANA, ORANGE, GRAPE, WATERMELON, STRAWBERRY, SPECIAL };
 enum class PowerupType { DOUBLE_POINTS, SLOW_MOTION, EXTRA_LIFE, MAGNET, SCORE_BOOST, FREEZE_TIME };
 enum class GameEffectType { SPEED_BOOST, SHIELD, DOUBLE_SCORE, MAGNET, INVISIBILITY, COLOR_SHIFT };
 enum class GameState { MENU, PLAYING, PAUSED, GAME_OVER, HIGH_SCORES, SETTINGS, SHOP, INSTRUCTIONS };
-enum class ParticleType { SPARKLE, EXPLOSION, TRAIL, SCORE_POPUP };
+enum class ParticleType { SPARKLE, EXPLOSION, TRAIL };
 enum class ShopItemType { BASKET_SKIN, FRUIT_SKIN, POWER_UP, BACKGROUND };
 enum class ChallengeType { SPEED_CHALLENGE, COMBO_CHALLENGE, ACCURACY_CHALLENGE, SURVIVAL_CHALLENGE, COLOR_CHALLENGE };
 
+// --- Particle Kernels ---
+// The particle arrays a kernel works on
+struct ParticleArrays {
+    int16_t* x;
+    int16_t* y;
+    const float* velocityX;
+    const float* velocityY;
+    uint8_t* stepsLeft;
+    uint64_t* alive; // One bit per particle, lowest bit first
+};
+
+// One rule step for particles [0, n): moves each by the whole part of its
+// velocity, counts its lifetime down and sets its alive bit if it still has
+// steps left and is on the width x height playfield.
+using ParticleKernel = void (*)(const ParticleArrays& p, int n, int width, int height);
+
+// Steps particles [begin, n) one at a time. alive must already be cleared.
+inline void stepParticleRange(const ParticleArrays& p, int begin, int n, int width, int height) {
+    const unsigned w = static_cast<unsigned>(width);
+    const unsigned h = static_cast<unsigned>(height);
+    for (int i = begin; i < n; ++i) {
+        int16_t x = static_cast<int16_t>(p.x[i] + static_cast<int>(p.velocityX[i]));
+        int16_t y = static_cast<int16_t>(p.y[i] + static_cast<int>(p.velocityY[i]));
+        uint8_t steps = static_cast<uint8_t>(p.stepsLeft[i] - 1);
+        p.x[i] = x;
+        p.y[i] = y;
+        p.stepsLeft[i] = steps;
+        bool alive = (steps != 0) & (static_cast<unsigned>(x) < w) & (static_cast<unsigned>(y) < h);
+        p.alive[i >> 6] |= uint64_t(alive) << (i & 63);
+    }
+}
+
+void stepParticlesScalar(const ParticleArrays& p, int n, int width, int height) {
+    std::fill(p.alive, p.alive + (n + 63) / 64, 0);
+    stepParticleRange(p, 0, n, width, height);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+// 8 particles per iteration
+__attribute__((target("sse4.2"))) void stepParticlesSse42(const ParticleArrays& p, int n, int width, int height) {
+    std::fill(p.alive, p.alive + (n + 63) / 64, 0);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i minusOne = _mm_set1_epi16(-1);
+    const __m128i one = _mm_set1_epi8(1);
+    const __m128i w = _mm_set1_epi16(static_cast<int16_t>(std::min(width, 32767)));
+    const __m128i h = _mm_set1_epi16(static_cast<int16_t>(std::min(height, 32767)));
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i dx = _mm_packs_epi32(_mm_cvttps_epi32(_mm_loadu_ps(p.velocityX + i)), _mm_cvttps_epi32(_mm_loadu_ps(p.velocityX + i + 4)));
+        __m128i dy = _mm_packs_epi32(_mm_cvttps_epi32(_mm_loadu_ps(p.velocityY + i)), _mm_cvttps_epi32(_mm_loadu_ps(p.velocityY + i + 4)));
+        __m128i x = _mm_add_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p.x + i)), dx);
+        __m128i y = _mm_add_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p.y + i)), dy);
+        __m128i steps = _mm_sub_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p.stepsLeft + i)), one);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p.x + i), x);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p.y + i), y);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(p.stepsLeft + i), steps);
+
+        __m128i inside = _mm_and_si128(_mm_and_si128(_mm_cmpgt_epi16(x, minusOne), _mm_cmpgt_epi16(w, x)),
+                                       _mm_and_si128(_mm_cmpgt_epi16(y, minusOne), _mm_cmpgt_epi16(h, y)));
+        __m128i expired = _mm_cvtepi8_epi16(_mm_cmpeq_epi8(steps, zero));
+        __m128i alive = _mm_andnot_si128(expired, inside);
+        uint64_t bits = static_cast<uint32_t>(_mm_movemask_epi8(_mm_packs_epi16(alive, zero)));
+        p.alive[i >> 6] |= bits << (i & 63);
+    }
+    stepParticleRange(p, i, n, width, height);
+}
+
+// 16 particles per iteration. The 256-bit packs work within each 128-bit
+// lane, so their results are put back in order with a 64-bit permute.
+__attribute__((target("avx2"))) void stepParticlesAvx2(const ParticleArrays& p, int n, int width, int height) {
+    std::fill(p.alive, p.alive + (n + 63) / 64, 0);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i minusOne = _mm256_set1_epi16(-1);
+    const __m128i one = _mm_set1_epi8(1);
+    const __m256i w = _mm256_set1_epi16(static_cast<int16_t>(std::min(width, 32767)));
+    const __m256i h = _mm256_set1_epi16(static_cast<int16_t>(std::min(height, 32767)));
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i dx = _mm256_permute4x64_epi64(_mm256_packs_epi32(_mm256_cvttps_epi32(_mm256_loadu_ps(p.velocityX + i)),
+                                                                 _mm256_cvttps_epi32(_mm256_loadu_ps(p.velocityX + i + 8))), 0xD8);
+        __m256i dy = _mm256_permute4x64_epi64(_mm256_packs_epi32(_mm256_cvttps_epi32(_mm256_loadu_ps(p.velocityY + i)),
+                                                                 _mm256_cvttps_epi32(_mm256_loadu_ps(p.velocityY + i + 8))), 0xD8);
+        __m256i x = _mm256_add_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p.x + i)), dx);
+        __m256i y = _mm256_add_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p.y + i)), dy);
+        __m128i steps = _mm_sub_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p.stepsLeft + i)), one);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(p.x + i), x);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(p.y + i), y);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p.stepsLeft + i), steps);
+
+        __m256i inside = _mm256_and_si256(_mm256_and_si256(_mm256_cmpgt_epi16(x, minusOne), _mm256_cmpgt_epi16(w, x)),
+                                          _mm256_and_si256(_mm256_cmpgt_epi16(y, minusOne), _mm256_cmpgt_epi16(h, y)));
+        __m256i expired = _mm256_cvtepi8_epi16(_mm_cmpeq_epi8(steps, _mm_setzero_si128()));
+        __m256i alive = _mm256_permute4x64_epi64(_mm256_packs_epi16(_mm256_andnot_si256(expired, inside), zero), 0xD8);
+        uint64_t bits = static_cast<uint32_t>(_mm_movemask_epi8(_mm256_castsi256_si128(alive)));
+        p.alive[i >> 6] |= bits << (i & 63);
+    }
+    stepParticleRange(p, i, n, width, height);
+}
+#endif
+
+struct ParticleKernelInfo {
+    const char* name;
+    ParticleKernel step;
+    bool supported; // By this CPU
+};
+
+// Every kernel in this build, fastest first
+std::vector<ParticleKernelInfo> particleKernels() {
+    std::vector<ParticleKernelInfo> kernels;
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    kernels.push_back({"avx2", stepParticlesAvx2, static_cast<bool>(__builtin_cpu_supports("avx2"))});
+    kernels.push_back({"sse4.2", stepParticlesSse42, static_cast<bool>(__builtin_cpu_supports("sse4.2"))});
+#endif
+    kernels.push_back({"scalar", stepParticlesScalar, true});
+    return kernels;
+}
+
+ParticleKernelInfo selectParticleKernel() {
+    for (const auto& kernel : particleKernels()) {
+        if (kernel.supported) return kernel;
+    }
+    return {"scalar", stepParticlesScalar, true};
+}
+
+// Picked by cpuid once, before main
+const ParticleKernelInfo ACTIVE_PARTICLE_KERNEL = selectParticleKernel();
+
 // --- Structures ---
-struct Fruit {
+// Game time. It only moves when the simulation ticks, by exactly one tick
+// period each time, so timers follow the game rather than the wall clock:
+// clock adjustments cannot touch them and they stand still during a pause.
+using SimClock = std::chrono::steady_clock;
+
+// The falling fruits, one array per field. A bit per slot marks the ones in
+// use and serves as the free list: spawning takes the lowest clear bit and
+// despawning clears it again, both O(1) without allocating. A fruit refers to
+// its kind by index into FRUIT_ARCHETYPES rather than carrying a copy.
+struct FruitPool {
+    static constexpr int CAPACITY = 64; // One bit of the alive mask per slot
+
+    std::array<int16_t, CAPACITY> x;
+    std::array<double, CAPACITY> y;         // Falls continuously; the row is its integer part
+    std::array<double, CAPACITY> previousY; // Before the last tick, for interpolation
+    std::array<double, CAPACITY> velocity;  // Multiplier on the game's fall speed
+    std::array<uint8_t, CAPACITY> kind;     // Index into FRUIT_ARCHETYPES
+    uint64_t alive = 0;
+
+    // Returns the slot used, or -1 if the pool is full
+    int spawn(int fruitKind, int column, double fallVelocity) {
+        if (alive == ~uint64_t(0)) return -1;
+        int slot = __builtin_ctzll(~alive);
+        alive |= uint64_t(1) << slot;
+        kind[slot] = static_cast<uint8_t>(fruitKind);
+        x[slot] = static_cast<int16_t>(column);
+        y[slot] = previousY[slot] = 0;
+        velocity[slot] = fallVelocity;
+        return slot;
+    }
+
+    void despawn(int slot) { alive &= ~(uint64_t(1) << slot); }
+    void clear() { alive = 0; }
+    int size() const { return __builtin_popcountll(alive); }
+
+    // Calls f(slot) for every fruit in use, lowest slot first. f may despawn the fruit it is given.
+    template <typename F>
+    void forEach(F&& f) const {
+        for (uint64_t remaining = alive; remaining; remaining &= remaining - 1) f(__builtin_ctzll(remaining));
+    }
+};
+
+struct Basket {
+    int x;
+    int width;
+    FruitType type; // Also its index into FRUIT_ARCHETYPES
+    Basket(int x, int width, FruitType type) : x(x), width(width), type(type) {}
+};
+
+// Where each basket catches, for landing and magnet lookups that do not
+// scan every basket. Baskets can overlap on a narrow playfield, so the
+// column table is kept per fruit type.
+struct BasketIndex {
+    // Rebuilds the index for a playfield width columns wide with typeCount fruit types
+    void rebuild(const std::vector<Basket>& baskets, int width, int typeCount) {
+        columns = width;
+        catcherAt.assign(static_cast<size_t>(typeCount) * width, -1);
+        byType.assign(typeCount, {});
+        for (size_t i = 0; i < baskets.size(); ++i) {
+            const Basket& basket = baskets[i];
+            int type = static_cast<int>(basket.type);
+            if (type < 0 || type >= typeCount) continue;
+            int16_t* row = catcherAt.data() + static_cast<size_t>(type) * width;
+            for (int x = std::max(0, basket.x - basket.width / 2); x <= std::min(width - 1, basket.x + basket.width / 2); ++x) {
+                if (row[x] < 0) row[x] = static_cast<int16_t>(i); // Earlier baskets win overlaps
+            }
+            byType[type].push_back({basket.x, static_cast<int>(i)});
+        }
+        for (auto& sorted : byType) std::sort(sorted.begin(), sorted.end());
+        stale = false;
+    }
+
+    // The basket of the given type that catches a fruit landing in column x, or -1
+    int catcher(int type, int x) const {
+        if (x < 0 || x >= columns || type < 0 || type >= static_cast<int>(byType.size())) return -1;
+        return catcherAt[static_cast<size_t>(type) * columns + x];
+    }
+
+    // The basket of the given type nearest to column x, or -1 if there is none.
+    // Ties go to the basket that comes first.
+    int nearest(int type, int x) const {
+        if (type < 0 || type >= static_cast<int>(byType.size()) || byType[type].empty()) return -1;
+        const auto& sorted = byType[type];
+        auto right = std::lower_bound(sorted.begin(), sorted.end(), std::pair<int, int>{x, -1});
+        int best = -1;
+        int bestDistance = 0;
+        auto consider = [&](const std::pair<int, int>& candidate) {
+            int distance = std::abs(candidate.first - x);
+            if (best < 0 || distance < bestDistance || (distance == bestDistance && candidate.second < best)) {
+                best = candidate.second;
+                bestDistance = distance;
+            }
+        };
+        if (right != sorted.end()) consider(*right);
+        if (right != sorted.begin()) {
+            // First basket of the nearest column on the left
+            consider(*std::lower_bound(sorted.begin(), right, std::pair<int, int>{std::prev(right)->first, -1}));
+        }
+        return best;
+    }
+
+    bool stale = true; // Set whenever a basket moves or changes width
+
+private:
+    int columns = 0;
+    std::vector<int16_t> catcherAt;                  // Basket index per fruit type and column, -1 if none
+    std::vector<std::vector<std::pair<int, int>>> byType; // (x, basket index) per fruit type, sorted
+};
+
+struct Achievement {
+    std::string name;
+    std::string description;
+    bool unlocked;
+    int requirement;
+};
+
+struct GameStats {
+    int totalFruitsCaught;
+    int totalSpecialFruitsCaught;
+    int highestCombo;
+    int totalScore;
+    int gamesPlayed;
+    SimClock::time_point startTime;
+    SimClock::time_point endTime; // For tracking game end time
+    int totalFruitsMissed;
+    int totalPowerUpsCollected;
+    int totalEffectsActivated;
+};
+
+// Totals of a headless run (--headless), summed over every game played.
+// Batch workers each fill their own and merge them when they finish.
+struct HeadlessReport {
+    uint64_t games;
+    uint64_t ticks;
+    uint64_t truncatedGames; // Stopped at the per-game tick limit with lives left
+    double wallSeconds;
+    double gameSeconds;
+    long long totalScore;
+    int maxScore;
+    long long totalLevel;
+    int maxLevel;
+    int maxCombo;
+    long long fruitsCaught;
+    long long specialFruitsCaught;
+    long long fruitsMissed;
+    long long powerUpsCollected;
+    long long effectsActivated;
+    std::vector<uint64_t> scoreHistogram; // Games per SCORE_HISTOGRAM_BUCKET points of final score
+    std::vector<uint64_t> levelHistogram; // Games per level reached
+    std::vector<uint64_t> missHistogram;  // Games per number of fruits missed
+
+    static void count(std::vector<uint64_t>& histogram, size_t index) {
+        if (index >= histogram.size()) histogram.resize(index + 1, 0);
+        histogram[index]++;
+    }
+
+    void merge(const HeadlessReport& other) {
+        games += other.games;
+        ticks += other.ticks;
+        truncatedGames += other.truncatedGames;
+        gameSeconds += other.gameSeconds;
+        totalScore += other.totalScore;
+        maxScore = std::max(maxScore, other.maxScore);
+        totalLevel += other.totalLevel;
+        maxLevel = std::max(maxLevel, other.maxLevel);
+        maxCombo = std::max(maxCombo, other.maxCombo);
+        fruitsCaught += other.fruitsCaught;
+        specialFruitsCaught += other.specialFruitsCaught;
+        fruitsMissed += other.fruitsMissed;
+        powerUpsCollected += other.powerUpsCollected;
+        effectsActivated += other.effectsActivated;
+        for (auto [mine, theirs] : {std::pair{&scoreHistogram, &other.scoreHistogram},
+                                    std::pair{&levelHistogram, &other.levelHistogram},
+                                    std::pair{&missHistogram, &other.missHistogram}}) {
+            if (theirs->size() > mine->size()) mine->resize(theirs->size(), 0);
+            for (size_t i = 0; i < theirs->size(); ++i) (*mine)[i] += (*theirs)[i];
+        }
+    }
+};
+
+// How a game ended; a replay must reproduce it exactly
+struct GameOutcome {
+    uint64_t ticks;
+    int score;
+    int level;
+    int lives;
+    int maxCombo;
+    int fruitsCaught;
+    int specialFruitsCaught;
+    int fruitsMissed;
+    int powerUpsCollected;
+    int effectsActivated;
+    bool operator==(const GameOutcome& other) const {
+        return ticks == other.ticks && score == other.score && level == other.level && lives == other.lives &&
+               maxCombo == other.maxCombo && fruitsCaught == other.fruitsCaught &&
+               specialFruitsCaught == other.specialFruitsCaught && fruitsMissed == other.fruitsMissed &&
+               powerUpsCollected == other.powerUpsCollected && effectsActivated == other.effectsActivated;
+    }
+    bool operator!=(const GameOutcome& other) const { return !(*this == other); }
+};
+
+// A recorded game: the settings and seed it started from, every input it
+// received tagged with the tick it was applied before, and its outcome.
+struct Replay {
+    struct Event {
+        uint64_t tick;
+        char key;   // 'a', 'd', 'p', 'q', or 'r' for a playfield resize
+        int width;  // Resize only
+        int height;
+    };
+
+    uint64_t seed = 0;
+    int tickRate = DEFAULT_TICK_RATE;
+    int width = SCREEN_WIDTH;
+    int height = SCREEN_HEIGHT;
+    int difficulty = 0;
+    std::vector<Event> events;
+    GameOutcome outcome = {};
+};
+
+struct PlayerProfile {
+    std::string name;
+    int totalGames;
+    int totalScore;
+    std::map<std::string, bool> achievements;
+    int highestLevel;
+    std::chrono::system_clock::time_point lastPlayed;
+};
+
+struct GameEffect {
+    GameEffectType type;
+    int duration;
+    bool active;
+    SimClock::time_point endTime;
+    uint64_t timer;  // TimerQueue id of the timer that ends the effect
+    int colorIndex;  // For Color Shift effect
+    GameEffect(GameEffectType t, int d) : type(t), duration(d), active(false), timer(0), colorIndex(0) {}
+};
+
+struct Powerup {
+    PowerupType type;
+    int duration;
+    bool active;
+};
+
+// Every live particle, one array per field. Live particles are packed at the
+// front, so a dead one is removed by moving the last one into its slot, and
+// the arrays are sized once so a burst never allocates.
+struct ParticleSystem {
+    static constexpr int DEFAULT_CAPACITY = 1 << 17;
+
+    std::vector<int16_t> x, y;
+    std::vector<float> velocityX, velocityY; // Cells per rule step; the whole part is applied
+    std::vector<uint16_t> glyph;             // GlyphTable id
+    std::vector<uint8_t> color;
+    std::vector<uint8_t> stepsLeft;          // Rule steps until the particle dies
+
+    explicit ParticleSystem(int capacity = DEFAULT_CAPACITY)
+        : x(capacity), y(capacity), velocityX(capacity), velocityY(capacity), glyph(capacity), color(capacity),
+          stepsLeft(capacity), alive((capacity + 63) / 64), capacity(capacity) {}
+
+    // Starts up to n particles at (column, row) with zero velocity and returns
+    // the index of the first; the burst runs to size(). Particles that do not
+    // fit are dropped.
+    int emit(int column, int row, uint16_t particleGlyph, uint8_t particleColor, int lifetimeSteps, int n) {
+        int first = count;
+        int end = std::min(capacity, count + std::max(0, n));
+        std::fill(x.begin() + first, x.begin() + end, static_cast<int16_t>(column));
+        std::fill(y.begin() + first, y.begin() + end, static_cast<int16_t>(row));
+        std::fill(velocityX.begin() + first, velocityX.begin() + end, 0.0f);
+        std::fill(velocityY.begin() + first, velocityY.begin() + end, 0.0f);
+        std::fill(glyph.begin() + first, glyph.begin() + end, particleGlyph);
+        std::fill(color.begin() + first, color.begin() + end, particleColor);
+        std::fill(stepsLeft.begin() + first, stepsLeft.begin() + end, static_cast<uint8_t>(lifetimeSteps));
+        count = end;
+        return first;
+    }
+
+    // One rule step: the kernel moves every particle and marks the survivors,
+    // then the dead ones are swapped out
+    void update(int width, int height, ParticleKernel kernel = ACTIVE_PARTICLE_KERNEL.step) {
+        kernel({x.data(), y.data(), velocityX.data(), velocityY.data(), stepsLeft.data(), alive.data()}, count, width, height);
+        compact();
+    }
+
+    void clear() { count = 0; }
+    int size() const { return count; }
+
+private:
+    // Fills each dead slot, lowest first, with the last live particle
+    void compact() {
+        for (int word = 0; word * 64 < count; ++word) {
+            for (uint64_t dead = ~alive[word]; dead; dead &= dead - 1) {
+                int i = word * 64 + __builtin_ctzll(dead);
+                if (i >= count) return;
+                int last = count - 1;
+                while (last > i && !(alive[last >> 6] >> (last & 63) & 1)) --last;
+                if (last == i) { // Nothing alive from i on
+                    count = i;
+                    return;
+                }
+                move(last, i);
+                count = last;
+            }
+        }
+    }
+
+    void move(int from, int to) {
+        x[to] = x[from];
+        y[to] = y[from];
+        velocityX[to] = velocityX[from];
+        velocityY[to] = velocityY[from];
+        glyph[to] = glyph[from];
+        color[to] = color[from];
+        stepsLeft[to] = stepsLeft[from];
+    }
+
+    std::vector<uint64_t> alive; // Written by the kernel each update
+    int capacity;
+    int count = 0;
+};
+
+struct ShopItem {
+    ShopItemType type;
+    std::string name;
+    std::string description;
+    int price;
+    bool unlocked;
+    std::string preview;
+};
+
+struct AchievementTier {
+    std::string name;
+    int requirement;
+    bool claimed;
+    std::string reward;
+};
+
+// Structure for game challenges
+struct Challenge {
+    ChallengeType type;
+    std::string description;
+    bool active;
+    int target;
+    int progress;
+    SimClock::time_point startTime;
+    uint64_t timer; // TimerQueue id of the timer that settles the challenge when its time is up
+
+    Challenge(ChallengeType type) : type(type), active(false), progress(0), timer(0) {
+        switch (type) {
+            case ChallengeType::SPEED_CHALLENGE:
+                description = "Catch 50 fruits in under 60 seconds";
+                target = 50;
+                break;
+            case ChallengeType::COMBO_CHALLENGE:
+                description = "Achieve a combo of 30";
+                target = 30;
+                break;
+            case ChallengeType::ACCURACY_CHALLENGE:
+                description = "Catch 100 fruits without missing more than 5";
+                target = 100;
+                break;
+            case ChallengeType::SURVIVAL_CHALLENGE:
+                description = "Survive for 120 seconds";
+                target = 120;
+                break;
+            case ChallengeType::COLOR_CHALLENGE:
+                description = "Catch 20 red fruits in a row";
+                target = 20;
+                break;
+            default:
+                description = "Unknown Challenge";
+                target = 0;
+        }
+    }
+};
+
+// --- Random Numbers ---
+// xoshiro256** (Blackman & Vigna). Fast, small, and the same sequence on
+// every platform for a given seed, unlike the std:: distributions.
+class Rng {
+public:
+    using result_type = uint64_t;
+
+    explicit Rng(uint64_t seed = 0) { reseed(seed); }
+
+    // The state is filled from splitmix64 so that any seed, including 0, is usable
+    void reseed(uint64_t seed) {
+        for (auto& word : state) word = splitmix64(seed);
+    }
+
+    // Advances a splitmix64 sequence and returns its next value
+    static uint64_t splitmix64(uint64_t& sequence) {
+        uint64_t z = (sequence += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    uint64_t next() {
+        const uint64_t result = rotl(state[1] * 5, 7) * 9;
+        const uint64_t t = state[1] << 17;
+        state[2] ^= state[0];
+        state[3] ^= state[1];
+        state[1] ^= state[2];
+        state[0] ^= state[3];
+        state[2] ^= t;
+        state[3] = rotl(state[3], 45);
+        return result;
+    }
+
+    // Uniform in [0, bound), without modulo bias (Lemire's method)
+    uint32_t below(uint32_t bound) {
+        uint64_t product = (next() >> 32) * bound;
+        uint32_t low = static_cast<uint32_t>(product);
+        if (low < bound) {
+            uint32_t threshold = static_cast<uint32_t>(-bound) % bound;
+            while (low < threshold) {
+                product = (next() >> 32) * bound;
+                low = static_cast<uint32_t>(product);
+            }
+        }
+        return static_cast<uint32_t>(product >> 32);
+    }
+
+    // Uniform in [low, high]
+    int range(int low, int high) { return low + static_cast<int>(below(static_cast<uint32_t>(high - low) + 1)); }
+
+    // True with the given probability in percent
+    bool chance(int percent) { return static_cast<int>(below(100)) < percent; }
+
+    // Advances by 2^128 steps. Streams split off this way never overlap.
+    Rng split() {
+        static constexpr uint64_t JUMP[] = {0x180EC6D33CFD0ABAULL, 0xD5A61266F0C9392CULL,
+                                            0xA9582618E03FC9AAULL, 0x39ABDC4529B1661CULL};
+        uint64_t jumped[4] = {0, 0, 0, 0};
+        for (uint64_t word : JUMP) {
+            for (int bit = 0; bit < 64; ++bit) {
+                if (word & (1ULL << bit)) {
+                    for (int i = 0; i < 4; ++i) jumped[i] ^= state[i];
+                }
+                next();
+            }
+        }
+        Rng stream = *this;
+        std::copy(jumped, jumped + 4, state);
+        return stream;
+    }
+
+    // UniformRandomBitGenerator, for use with <algorithm>
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return ~result_type(0); }
+    result_type operator()() { return next(); }
+
+private:
+    static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+    uint64_t state[4];
+};
+
+// A seed for when none was given
+uint64_t randomSeed() {
+    std::random_device device;
+    return (static_cast<uint64_t>(device()) << 32) | device();
+}
+
+// --- Timers ---
+// One-shot timers on the game's virtual clock, so they all stand still while
+// the game is paused. Deadlines sit in a min-heap: a tick that fires nothing
+// costs one comparison. Timers due at the same moment fire in the order they
+// were scheduled, which keeps replays exact.
+class TimerQueue {
+public:
+    using Id = uint64_t;
+    using Callback = std::function<void()>;
+
+    TimerQueue() : nextId(1) {}
+
+    Id schedule(SimClock::time_point deadline, Callback callback) {
+        Id id = nextId++;
+        heap.push({deadline, id});
+        callbacks.emplace(id, std::move(callback));
+        return id;
+    }
+
+    // The heap entry stays behind and is skipped when it comes due
+    void cancel(Id id) { callbacks.erase(id); }
+
+    void clear() {
+        heap = decltype(heap)();
+        callbacks.clear();
+    }
+
+    // Fires every timer due by `now`, earliest first. Timers scheduled by a
+    // callback fire in the same call if they are already due.
+    void runDue(SimClock::time_point now) {
+        while (!heap.empty() && heap.top().first <= now) {
+            Id id = heap.top().second;
+            heap.pop();
+            auto it = callbacks.find(id);
+            if (it == callbacks.end()) continue; // Cancelled
+            Callback callback = std::move(it->second);
+            callbacks.erase(it);
+            callback();
+        }
+    }
+
+private:
+    using Entry = std::pair<SimClock::time_point, Id>;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> heap;
+    std::map<Id, Callback> callbacks;
+    Id nextId;
+};
+
+// --- Rendering ---
+// Decodes the UTF-8 sequence starting at text[i] and advances i past it.
+// Malformed input decodes as U+FFFD one byte at a time.
+constexpr char32_t decodeUtf8(std::string_view text, size_t& i) {
+    unsigned char lead = static_cast<unsigned char>(text[i]);
+    size_t length = lead < 0x80 ? 1 : lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : lead >= 0xC0 ? 2 : 0;
+    if (length == 0 || i + length > text.size()) {
+        i++;
+        return 0xFFFD;
+    }
+    char32_t cp = length == 1 ? lead : lead & (0xFF >> (length + 1));
+    for (size_t k = 1; k < length; ++k) cp = (cp << 6) | (static_cast<unsigned char>(text[i + k]) & 0x3F);
+    i += length;
+    return cp;
+}
+
+// Code points that attach to the preceding one instead of starting a new glyph:
+// combining marks, variation selectors, the keycap mark, ZWJ and skin tones.
+constexpr bool isClusterExtender(char32_t cp) {
+    return (cp >= 0x0300 && cp <= 0x036F) || (cp >= 0x20D0 && cp <= 0x20FF) ||
+           (cp >= 0xFE00 && cp <= 0xFE0F) || cp == 0x200D || (cp >= 0x1F3FB && cp <= 0x1F3FF);
+}
+
+// Code point ranges terminals draw two columns wide, in ascending order
+constexpr char32_t WIDE_RANGES[][2] = {
+    {0x1100, 0x115F}, {0x231A, 0x231B}, {0x2329, 0x232A}, {0x23E9, 0x23EC}, {0x23F0, 0x23F0},
+    {0x23F3, 0x23F3}, {0x25FD, 0x25FE}, {0x2614, 0x2615}, {0x2648, 0x2653}, {0x267F, 0x267F},
+    {0x2693, 0x2693}, {0x26A1, 0x26A1}, {0x26AA, 0x26AB}, {0x26BD, 0x26BE}, {0x26C4, 0x26C5},
+    {0x26CE, 0x26CE}, {0x26D4, 0x26D4}, {0x26EA, 0x26EA}, {0x26F2, 0x26F3}, {0x26F5, 0x26F5},
+    {0x26FA, 0x26FA}, {0x26FD, 0x26FD}, {0x2705, 0x2705}, {0x270A, 0x270B}, {0x2728, 0x2728},
+    {0x274C, 0x274C}, {0x274E, 0x274E}, {0x2753, 0x2755}, {0x2757, 0x2757}, {0x2795, 0x2797},
+    {0x27B0, 0x27B0}, {0x27BF, 0x27BF}, {0x2B1B, 0x2B1C}, {0x2B50, 0x2B50}, {0x2B55, 0x2B55},
+    {0x2E80, 0x303E}, {0x3041, 0x33FF}, {0x3400, 0x4DBF}, {0x4E00, 0x9FFF}, {0xA000, 0xA4CF},
+    {0xAC00, 0xD7A3}, {0xF900, 0xFAFF}, {0xFE30, 0xFE4F}, {0xFF00, 0xFF60}, {0xFFE0, 0xFFE6},
+    {0x1F004, 0x1F004}, {0x1F0CF, 0x1F0CF}, {0x1F18E, 0x1F18E}, {0x1F191, 0x1F19A}, {0x1F200, 0x1F251},
+    {0x1F300, 0x1F64F}, {0x1F680, 0x1F6FF}, {0x1F7E0, 0x1F7EB}, {0x1F90C, 0x1F9FF}, {0x1FA70, 0x1FAFF},
+    {0x20000, 0x3FFFD}
+};
+
+// Terminal column width of one code point, following wcwidth's East Asian
+// Wide and emoji presentation ranges for the characters a game can show.
+constexpr int codepointWidth(char32_t cp) {
+    if (cp < 0x20 || (cp >= 0x7F && cp < 0xA0)) return 0;
+    if (isClusterExtender(cp) || (cp >= 0x200B && cp <= 0x200F)) return 0;
+    if (cp < 0x1100) return 1;
+    for (const auto& range : WIDE_RANGES) {
+        if (cp < range[0]) break;
+        if (cp <= range[1]) return 2;
+    }
+    return 1;
+}
+
+// Length in bytes of the glyph (base code point plus anything attached to it)
+// starting at text[i]
+constexpr size_t clusterLength(std::string_view text, size_t i) {
+    size_t start = i;
+    decodeUtf8(text, i);
+    while (i < text.size()) {
+        size_t next = i;
+        char32_t cp = decodeUtf8(text, next);
+        if (!isClusterExtender(cp)) break;
+        i = next;
+        if (cp == 0x200D && i < text.size()) decodeUtf8(text, i); // ZWJ pulls in the next code point
+    }
+    return i - start;
+}
+
+// clusterLength, but a plain ASCII character on its own is taken as is. One
+// followed by a combining mark, like the digit of a keycap, is not.
+constexpr size_t glyphLength(std::string_view text, size_t i) {
+    bool plain = static_cast<unsigned char>(text[i]) < 0x80 && (i + 1 == text.size() || static_cast<unsigned char>(text[i + 1]) < 0x80);
+    return plain ? 1 : clusterLength(text, i);
+}
+
+// Display width of a single glyph. VS16 and the keycap mark request emoji
+// presentation, which terminals draw two columns wide.
+constexpr int clusterWidth(std::string_view cluster) {
+    size_t i = 0;
+    int width = codepointWidth(decodeUtf8(cluster, i));
+    while (i < cluster.size()) {
+        char32_t cp = decodeUtf8(cluster, i);
+        if (cp == 0xFE0F || cp == 0x20E3) width = 2;
+        else if (cp == 0xFE0E) width = 1;
+    }
+    return width;
+}
+
+// Display width of a string, skipping ANSI escape sequences
+constexpr int displayWidth(std::string_view text) {
+    int width = 0;
+    for (size_t i = 0; i < text.size();) {
+        if (text[i] == '\033') {
+            i++;
+            if (i < text.size() && text[i] == '[') {
+                while (++i < text.size() && !(text[i] >= 0x40 && text[i] <= 0x7E)) {}
+                i++;
+            }
+            continue;
+        }
+        size_t length = glyphLength(text, i);
+        if (length == 1 && static_cast<unsigned char>(text[i]) < 0x80) {
+            width += text[i] >= 0x20 ? 1 : 0;
+        } else {
+            width += clusterWidth(text.substr(i, length));
+        }
+        i += length;
+    }
+    return width;
+}
+
+// Every glyph drawn on screen is decoded once, interned, and referred to by a
+// small id that carries its byte encoding and display width. Ids below 128
+// are the ASCII characters themselves. All glyphs are interned before the
+// render thread starts and the table is then frozen, so both threads only
+// read it and need no lock; interning a new glyph after that throws.
+class GlyphTable {
+public:
+    static constexpr size_t MAX_GLYPHS = 4096;
+    static constexpr uint16_t CONTINUATION = 0; // Right half of a wide glyph; NUL is never drawn
+
+    struct Glyph {
+        std::string bytes;
+        uint8_t width;
+        bool exactWidth; // False for emoji sequences some terminals draw at a different width
+    };
+
+    GlyphTable() {
+        glyphs.reserve(MAX_GLYPHS);
+        for (int c = 0; c < 128; ++c) glyphs.push_back({std::string(1, static_cast<char>(c)), static_cast<uint8_t>(c >= 0x20 ? 1 : 0), true});
+    }
+    // Interns a single glyph
+    uint16_t intern(std::string_view bytes) {
+        if (bytes.size() == 1 && static_cast<unsigned char>(bytes[0]) < 128) return static_cast<uint8_t>(bytes[0]);
+        auto it = ids.find(bytes);
+        if (it != ids.end()) return it->second;
+        if (frozen) throw std::logic_error("glyph interned after the table was frozen: " + std::string(bytes));
+        if (glyphs.size() >= MAX_GLYPHS) return '?';
+        uint16_t id = static_cast<uint16_t>(glyphs.size());
+        size_t first = 0;
+        decodeUtf8(bytes, first);
+        glyphs.push_back({std::string(bytes), static_cast<uint8_t>(clusterWidth(bytes)), first == bytes.size()});
+        ids.emplace(std::string(bytes), id);
+        return id;
+    }
+    // Interns every glyph of a piece of text, so the renderer can lay it out
+    void internText(std::string_view text) {
+        for (size_t i = 0; i < text.size();) {
+            size_t length = clusterLength(text, i);
+            intern(text.substr(i, length));
+            i += length;
+        }
+    }
+    // Makes the table read-only
+    void freeze() { frozen = true; }
+    // Lookup without interning
+    uint16_t find(std::string_view bytes) const {
+        if (bytes.size() == 1 && static_cast<unsigned char>(bytes[0]) < 128) return static_cast<uint8_t>(bytes[0]);
+        auto it = ids.find(bytes);
+        return it != ids.end() ? it->second : '?';
+    }
+    const std::string& bytes(uint16_t id) const { return glyphs[id].bytes; }
+    int width(uint16_t id) const { return glyphs[id].width; }
+    bool hasExactWidth(uint16_t id) const { return glyphs[id].exactWidth; }
+
+private:
+    std::vector<Glyph> glyphs;
+    std::map<std::string, uint16_t, std::less<>> ids; // Transparent so lookups need no temporary string
+    bool frozen = false;
+};
+
+// Reusable byte buffer a whole screen is composed into, so that it reaches
+// the terminal with a single write(2) instead of many small stream insertions.
+class OutputArena {
+public:
+    explicit OutputArena(size_t capacity) : buffer(capacity), used(0), writeCalls(0) {}
+
+    void append(std::string_view text) {
+        reserve(text.size());
+        std::memcpy(buffer.data() + used, text.data(), text.size());
+        used += text.size();
+    }
+
+    void append(char c) {
+        reserve(1);
+        buffer[used++] = c;
+    }
+
+    void appendRepeat(char c, size_t count) {
+        reserve(count);
+        std::memset(buffer.data() + used, c, count);
+        used += count;
+    }
+
+    void appendInt(long value) {
+        char digits[24];
+        auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        append(std::string_view(digits, result.ptr - digits));
+    }
+
+    // printf-style formatting straight into the arena
+    void appendf(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+        va_list args;
+        va_start(args, format);
+        va_list retry;
+        va_copy(retry, args);
+        int n = std::vsnprintf(buffer.data() + used, buffer.size() - used, format, args);
+        if (n > 0 && used + n >= buffer.size()) {
+            reserve(n + 1);
+            std::vsnprintf(buffer.data() + used, buffer.size() - used, format, retry);
+        }
+        va_end(retry);
+        va_end(args);
+        if (n > 0) used += n;
+    }
+
+    // Writes everything composed so far to fd and empties the arena.
+    // Returns the number of write(2) calls it took.
+    int flush(int fd) {
+        int calls = 0;
+        size_t offset = 0;
+        while (offset < used) {
+            ssize_t n = write(fd, buffer.data() + offset, used - offset);
+            calls++;
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                if (errno == EAGAIN) {
+                    struct pollfd pfd = {fd, POLLOUT, 0};
+                    poll(&pfd, 1, -1);
+                    continue;
+                }
+                break;
+            }
+            offset += static_cast<size_t>(n);
+        }
+        used = 0;
+        writeCalls += calls;
+        return calls;
+    }
+
+    size_t size() const { return used; }
+    // Drops everything appended after the first size bytes
+    void truncate(size_t size) { used = std::min(used, size); }
+    uint64_t totalWriteCalls() const { return writeCalls; }
+
+private:
+    // Grows only if a frame outgrows everything seen before
+    void reserve(size_t extra) {
+        if (used + extra > buffer.size()) buffer.resize(std::max(buffer.size() * 2, used + extra));
+    }
+
+    std::vector<char> buffer;
+    size_t used;
+    uint64_t writeCalls;
+};
+
+enum CellAttr : uint8_t { ATTR_NONE = 0, ATTR_BOLD = 1 };
+
+// SGR escapes for the eight basic foreground colours, indexed by colour number
+constexpr std::string_view SGR_COLORS[] = {
+    "\033[30m", // Black
+    "\033[31m", // Red
+    "\033[32m", // Green
+    "\033[33m", // Yellow
+    "\033[34m", // Blue
+    "\033[35m", // Magenta
+    "\033[36m", // Cyan
+    "\033[37m"  // White
+};
+constexpr std::string_view SGR_RESET = "\033[0m";
+constexpr std::string_view SGR_BOLD = "\033[1m";
+constexpr std::string_view SGR_NORMAL_INTENSITY = "\033[22m";
+
+// Tracks the terminal's current SGR state so that colour and attribute
+// escapes are only written on transitions. Runs of same-coloured cells then
+// cost a single escape.
+class SgrEncoder {
+public:
+    static constexpr uint8_t UNKNOWN = 0xFF;
+    static constexpr uint8_t DEFAULT_COLOR = 0xFE;
+
+    SgrEncoder() : color(UNKNOWN), attr(UNKNOWN) {}
+
+    // Something else wrote to the terminal, so its state can no longer be assumed
+    void invalidate() { color = attr = UNKNOWN; }
+
+    void reset(OutputArena& out) {
+        out.append(SGR_RESET);
+        color = DEFAULT_COLOR;
+        attr = ATTR_NONE;
+    }
+
+    void set(OutputArena& out, uint8_t newColor, uint8_t newAttr) {
+        if (newColor >= 8) {
+            if (color != DEFAULT_COLOR || attr != ATTR_NONE) reset(out);
+            if (newAttr & ATTR_BOLD) setAttr(out, newAttr);
+            return;
+        }
+        if (newAttr != attr) setAttr(out, newAttr);
+        if (newColor != color) {
+            out.append(SGR_COLORS[newColor]);
+            color = newColor;
+        }
+    }
+
+private:
+    void setAttr(OutputArena& out, uint8_t newAttr) {
+        out.append(newAttr & ATTR_BOLD ? SGR_BOLD : SGR_NORMAL_INTENSITY);
+        attr = newAttr;
+    }
+
+    uint8_t color;
+    uint8_t attr;
+};
+
+struct Cell {
+    uint16_t glyph;
+    uint8_t color;
+    uint8_t attr;
+    bool operator==(const Cell& other) const {
+        return glyph == other.glyph && color == other.color && attr == other.attr;
+    }
+    bool operator!=(const Cell& other) const { return !(*this == other); }
+};
+
+const Cell BLANK_CELL = {' ', 7, ATTR_NONE};
+
+// Retained screen contents. The frame is composed into the back buffer and
+// present() emits only the cells that differ from what the terminal shows.
+class FrameBuffer {
+public:
+    FrameBuffer(const GlyphTable& glyphs, int width, int height)
+        : glyphs(glyphs), width(0), height(0), fullRedraw(true) {
+        resize(width, height);
+    }
+
+    void resize(int w, int h) {
+        width = w;
+        height = h;
+        front.assign(static_cast<size_t>(w) * h, BLANK_CELL);
+        back.assign(static_cast<size_t>(w) * h, BLANK_CELL);
+        fullRedraw = true;
+    }
+
+    void clear() { std::fill(back.begin(), back.end(), BLANK_CELL); }
+
+    // Forget what the terminal shows, e.g. after a menu screen has drawn over it
+    void invalidate() {
+        fullRedraw = true;
+        sgr.invalidate();
+    }
+
+    // Places a glyph and returns the number of columns it covers. A wide glyph
+    // also claims the cell to its right; one that would not fit is drawn blank.
+    int put(int x, int y, uint16_t glyph, uint8_t color, uint8_t attr = ATTR_NONE) {
+        if (x < 0 || x >= width || y < 0 || y >= height) return 1;
+        int glyphWidth = std::max(1, glyphs.width(glyph));
+        if (x + glyphWidth > width) {
+            glyph = ' ';
+            glyphWidth = 1;
+        }
+        Cell* row = back.data() + static_cast<size_t>(y) * width;
+        // Overwriting either half of a wide glyph blanks the other half
+        if (row[x].glyph == GlyphTable::CONTINUATION && x > 0) row[x - 1].glyph = ' ';
+        if (x + 1 < width && row[x + 1].glyph == GlyphTable::CONTINUATION) row[x + 1].glyph = ' ';
+        row[x] = {glyph, color, attr};
+        if (glyphWidth == 2) {
+            if (x + 2 < width && row[x + 2].glyph == GlyphTable::CONTINUATION) row[x + 2].glyph = ' ';
+            row[x + 1] = {GlyphTable::CONTINUATION, color, attr};
+        }
+        return glyphWidth;
+    }
+
+    // Writes a single line of text starting at (x, y), laid out by display
+    // columns. Returns the number of columns used.
+    int putText(int x, int y, std::string_view text, uint8_t color) {
+        int columns = 0;
+        for (size_t i = 0; i < text.size();) {
+            size_t length = glyphLength(text, i);
+            columns += put(x + columns, y, glyphs.find(text.substr(i, length)), color);
+            i += length;
+        }
+        return columns;
+    }
+
+    // Copies a run of cells that was laid out in advance to (x, y), clipped to
+    // maxColumns and the frame edge. A wide glyph cut by the clip is drawn blank.
+    // Returns the number of columns used.
+    int blit(int x, int y, const std::vector<Cell>& cells, int maxColumns) {
+        if (x < 0 || x >= width || y < 0 || y >= height) return 0;
+        int count = std::min({static_cast<int>(cells.size()), maxColumns, width - x});
+        if (count <= 0) return 0;
+        Cell* row = back.data() + static_cast<size_t>(y) * width;
+        if (row[x].glyph == GlyphTable::CONTINUATION && x > 0) row[x - 1].glyph = ' ';
+        if (x + count < width && row[x + count].glyph == GlyphTable::CONTINUATION) row[x + count].glyph = ' ';
+        std::copy(cells.begin(), cells.begin() + count, row + x);
+        if (count < static_cast<int>(cells.size()) && cells[count].glyph == GlyphTable::CONTINUATION) row[x + count - 1].glyph = ' ';
+        return count;
+    }
+
+    // Appends the escape sequences needed to bring the terminal up to date
+    // with the back buffer and returns the number of bytes appended.
+    size_t present(OutputArena& out) {
+        size_t startSize = out.size();
+        if (fullRedraw) {
+            // A cleared terminal shows blank cells, so only the drawn ones need writing
+            sgr.reset(out);
+            out.append("\033[H\033[2J");
+            std::fill(front.begin(), front.end(), BLANK_CELL);
+            fullRedraw = false;
+        }
+        int cursorX = -1, cursorY = -1;
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                size_t i = static_cast<size_t>(y) * width + x;
+                const Cell& cell = back[i];
+                if (cell == front[i]) continue;
+                front[i] = cell;
+                if (cell.glyph == GlyphTable::CONTINUATION) continue; // Drawn by the glyph to its left
+                if (x != cursorX || y != cursorY) {
+                    out.append("\033[");
+                    out.appendInt(y + 1);
+                    out.append(';');
+                    out.appendInt(x + 1);
+                    out.append('H');
+                }
+                // A plain space looks the same in any foreground colour
+                if (cell.glyph != ' ' || cell.attr != ATTR_NONE) sgr.set(out, cell.color, cell.attr);
+                out.append(glyphs.bytes(cell.glyph));
+                if (glyphs.hasExactWidth(cell.glyph)) {
+                    cursorX = x + std::max(1, glyphs.width(cell.glyph));
+                    cursorY = y;
+                } else {
+                    cursorX = cursorY = -1; // Re-position rather than trust the terminal's width
+                }
+            }
+        }
+        return out.size() - startSize;
+    }
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+
+private:
+    const GlyphTable& glyphs;
+    int width;
+    int height;
+    std::vector<Cell> front; // What the terminal currently shows
+    std::vector<Cell> back;  // The frame being composed
+    bool fullRedraw;
+    SgrEncoder sgr;          // Colour state the terminal is left in by present()
+};
+
+// One line of the HUD, cached as laid-out cells. It is keyed on the values
+// it shows and only re-formatted when one of them changes; every other frame
+// just copies the cells into the frame buffer, which in turn only emits bytes
+// for the cells that differ from the terminal.
+class HudLine {
+public:
+    HudLine() : valid(false) {}
+
+    // Returns true if the key changed, in which case the caller rebuilds the line
+    bool needsUpdate(std::initializer_list<long> values) {
+        if (valid && std::equal(values.begin(), values.end(), key.begin(), key.end())) return false;
+        key.assign(values.begin(), values.end());
+        cells.clear();
+        valid = true;
+        return true;
+    }
+
+    void invalidate() { valid = false; }
+
+    // Lays text out after what the line already holds. Glyphs must already be interned.
+    void append(const GlyphTable& glyphs, std::string_view text, uint8_t color) {
+        for (size_t i = 0; i < text.size();) {
+            size_t length = glyphLength(text, i);
+            uint16_t glyph = glyphs.find(text.substr(i, length));
+            cells.push_back({glyph, color, ATTR_NONE});
+            if (glyphs.width(glyph) == 2) cells.push_back({GlyphTable::CONTINUATION, color, ATTR_NONE});
+            i += length;
+        }
+    }
+
+    int width() const { return static_cast<int>(cells.size()); }
+    const std::vector<Cell>& getCells() const { return cells; }
+
+private:
+    std::vector<long> key;
+    std::vector<Cell> cells;
+    bool valid;
+};
+
+// The HUD lines drawn around the playfield. Owned by the render thread.
+struct HudWidgets {
+    HudLine playerInfo;
+    HudLine levelInfo;
+    HudLine combo;
+    HudLine progress;
+    HudLine effects;
+    HudLine powerup;
+    uint64_t refreshes = 0; // Lines re-formatted, as opposed to copied from the cache
+
+    void invalidate() {
+        for (HudLine* line : {&playerInfo, &levelInfo, &combo, &progress, &effects, &powerup}) line->invalidate();
+    }
+};
+
+// Everything the renderer needs to draw one in-game frame. The simulation
+// fills one in each tick and hands it over, so the render thread never
+// touches live Game state. Vectors keep their capacity between uses.
+struct RenderSnapshot {
+    struct BasketView {
+        int16_t x;
+        int16_t width;
+        uint16_t glyph;
+    };
+    struct ParticleView {
+        int16_t x;
+        int16_t y;
+        uint16_t glyph;
+        uint8_t color;
+    };
+    struct FruitView {
+        int16_t x;
+        uint16_t glyph;
+        uint8_t color;
+        double y;         // Row after the newest tick
+        double previousY; // Row before it; the renderer interpolates in between
+    };
+
+    uint64_t sequence = 0;
+    int screenWidth = SCREEN_WIDTH;
+    int screenHeight = SCREEN_HEIGHT;
+    int terminalColumns = 0; // 0 if unknown
+    int terminalRows = 0;
+    std::string playerName;
+    int score = 0;
+    int lives = 0;
+    int level = 0;
+    int difficultyLevel = 0;
+    int combo = 0;
+    int comboMultiplier = 1;
+    std::array<int16_t, EFFECT_COUNT> effectSeconds{}; // Remaining duration per GameEffectType, -1 if inactive
+    int powerupType = -1;                               // PowerupType, -1 if none
+    int powerupSeconds = 0;
+    bool paused = false;
+    std::chrono::steady_clock::time_point tickStart; // Wall time the newest tick stands for
+    std::chrono::nanoseconds tickPeriod{1};
+    std::vector<BasketView> baskets;
+    std::vector<ParticleView> particles;
+    std::vector<FruitView> fruits;
+};
+
+// Lock-free single-producer/single-consumer triple buffer. The producer always
+// has a free slot to fill and the consumer always picks up the newest
+// published one, so neither side ever waits for the other.
+template <typename T>
+class TripleBuffer {
+public:
+    TripleBuffer() : writeIndex(0), middle(1), readIndex(2) {}
+
+    T& writeSlot() { return slots[writeIndex]; }
+
+    // Hands the write slot to the consumer. Returns false if the previously
+    // published slot was never consumed and has now been overwritten.
+    bool publish() {
+        uint8_t previous = middle.exchange(writeIndex | FRESH, std::memory_order_acq_rel);
+        writeIndex = previous & INDEX_MASK;
+        return !(previous & FRESH);
+    }
+
+    // Swaps in the newest published slot. Returns false if nothing new was published.
+    bool consume() {
+        if (!(middle.load(std::memory_order_relaxed) & FRESH)) return false;
+        uint8_t previous = middle.exchange(readIndex, std::memory_order_acq_rel);
+        readIndex = previous & INDEX_MASK;
+        return true;
+    }
+
+    const T& readSlot() const { return slots[readIndex]; }
+
+    // True while a published slot is waiting to be consumed
+    bool fresh() const { return middle.load(std::memory_order_relaxed) & FRESH; }
+
+private:
+    static constexpr uint8_t INDEX_MASK = 0x3;
+    static constexpr uint8_t FRESH = 0x4;
+
+    T slots[3];
+    uint8_t writeIndex;         // Producer only
+    std::atomic<uint8_t> middle; // Slot in flight, tagged FRESH until consumed
+    uint8_t readIndex;          // Consumer only
+};
+
+// Per-frame occupancy of the playfield. Baskets and particles are stamped in
+// once per frame, so drawing a cell is a lookup instead of a scan.
+struct PlayfieldRaster {
+    std::vector<int16_t> basketAt;   // Basket index for each column of the basket row, -1 if empty
+    std::vector<int32_t> particleAt; // First particle index for each playfield cell, -1 if empty
+    std::vector<int16_t> fruitAt;    // Fruit index for each playfield cell, -1 if empty
+};
+
+// Output volume of the in-game renderer
+struct RenderStats {
+    uint64_t framesPresented;
+    uint64_t totalBytes;
+    size_t lastFrameBytes;
+    size_t peakFrameBytes;
+    uint64_t totalWriteCalls;
+    int lastFrameWriteCalls;
+    uint64_t droppedFrames;    // Snapshots replaced before the render thread picked them up
+    uint64_t duplicatedFrames; // Frames that redrew the last snapshot at a later point in the tick
+    uint64_t skippedFrames;    // Render ticks held back because the terminal was still draining output
+    uint64_t coalescedFrames;  // Presented frames that folded in more than one snapshot
+    uint64_t hudRefreshes;     // HUD lines re-formatted because what they show changed
+};
+
+const std::vector<int> FRAME_RATES = {15, 30, 60, 120};
+const int DEFAULT_FRAME_RATE_INDEX = 2;
+const int MAX_OUTPUT_BACKLOG = 4096; // Bytes queued to the terminal before frames are skipped
+
+// True while the terminal has not yet drained what was written to it.
+// Uses the tty output queue where available, otherwise asks whether a write
+// would block.
+bool outputBacklogged(int fd) {
+    int queued = 0;
+    if (ioctl(fd, TIOCOUTQ, &queued) == 0) return queued > MAX_OUTPUT_BACKLOG;
+    struct pollfd pfd = {fd, POLLOUT, 0};
+    return poll(&pfd, 1, 0) == 1 && !(pfd.revents & POLLOUT);
+}
+
+// Set from the SIGWINCH handler; the game re-lays out the playfield when it sees it
+std::atomic<bool> terminalResized(false);
+// Set when the game resumes after being stopped; whatever the terminal showed is gone
+std::atomic<bool> screenLost(false);
+
+// Self-pipe the signal handlers write to, so a thread blocked in poll() wakes up for them
+int signalWakeFds[2] = {-1, -1};
+
+void openSignalWakePipe() {
+    if (signalWakeFds[0] >= 0 || pipe(signalWakeFds) < 0) return;
+    for (int fd : signalWakeFds) fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+}
+
+// Async-signal-safe
+void wakeForSignal() {
+    if (signalWakeFds[1] < 0) return;
+    ssize_t written = write(signalWakeFds[1], "s", 1);
+    (void)written; // A full pipe already has a wake-up waiting
+}
+
+void drainSignalWakes() {
+    char bytes[64];
+    while (signalWakeFds[0] >= 0 && read(signalWakeFds[0], bytes, sizeof(bytes)) > 0) {
+    }
+}
+
+// --- Archetypes ---
+// What every kind of fruit, power-up and effect looks like and is worth,
+// fixed at compile time. Live objects refer to an entry by index; for
+// power-ups and effects the index is the enum value.
+struct FruitArchetype {
     FruitType type;
-    std::string symbol;
+    std::string_view glyph;
+    std::string_view name;
     int points;
-    std::string name;
-    double velocity_y;  // Add velocity in y direction
-    Fruit(FruitType type, const std::string& symbol, int points, const std::string& name)
-        : type(type), symbol(symbol), points(points), name(name), velocity_y(1.0) {}
+    uint8_t color;
+    uint8_t width; // Display columns of the glyph
+};
+
+struct PowerupArchetype {
+    PowerupType type;
+    std::string_view glyph;
+    std::string_view name;
+    uint8_t color;
+    uint8_t width;
+};
+
+struct EffectArchetype {
+    GameEffectType type;
+    std::string_view glyph;
+    std::string_view name;
+    uint8_t color;
+    uint8_t width;
 };
 
-struct Basket {
-    int x;
-    int width;
-    FruitType type;
-    std::string symbol;
-    Basket(int x, int width, FruitType type, const std::string& symbol) : x(x), width(width), type(type), symbol(symbol) {}
-};
+constexpr std::array<FruitArchetype, 7> FRUIT_ARCHETYPES = {{
+    {FruitType::APPLE, "🍎", "Apple", 10, 1, displayWidth("🍎")},
+    {FruitType::BANANA, "🍌", "Banana", 15, 3, displayWidth("🍌")},
+    {FruitType::ORANGE, "🍊", "Orange", 12, 3, displayWidth("🍊")},
+    {FruitType::GRAPE, "🍇", "Grape", 8, 5, displayWidth("🍇")},
+    {FruitType::WATERMELON, "🍉", "Watermelon", 20, 2, displayWidth("🍉")},
+    {FruitType::STRAWBERRY, "🍓", "Strawberry", 18, 1, displayWidth("🍓")},
+    {FruitType::SPECIAL, "🌟", "Star", 30, 3, displayWidth("🌟")},
+}};
+
+constexpr std::array<PowerupArchetype, 6> POWERUP_ARCHETYPES = {{
+    {PowerupType::DOUBLE_POINTS, "2️⃣X", "Double Points", 6, displayWidth("2️⃣X")},
+    {PowerupType::SLOW_MOTION, "⏱️", "Slow Motion", 6, displayWidth("⏱️")},
+    {PowerupType::EXTRA_LIFE, "❤️", "Extra Life", 6, displayWidth("❤️")},
+    {PowerupType::MAGNET, "🧲", "Magnet", 6, displayWidth("🧲")},
+    {PowerupType::SCORE_BOOST, "💯", "Score Boost", 6, displayWidth("💯")},
+    {PowerupType::FREEZE_TIME, "❄️", "Freeze Time", 6, displayWidth("❄️")},
+}};
+
+constexpr std::array<EffectArchetype, EFFECT_COUNT> EFFECT_ARCHETYPES = {{
+    {GameEffectType::SPEED_BOOST, "💨", "Speed Boost", 7, displayWidth("💨")},
+    {GameEffectType::SHIELD, "🛡️", "Shield", 7, displayWidth("🛡️")},
+    {GameEffectType::DOUBLE_SCORE, "2️⃣X", "Double Score", 7, displayWidth("2️⃣X")},
+    {GameEffectType::MAGNET, "🧲", "Magnet", 7, displayWidth("🧲")},
+    {GameEffectType::INVISIBILITY, "👻", "Invisibility", 7, displayWidth("👻")},
+    {GameEffectType::COLOR_SHIFT, "🎨", "Color Shift", 7, displayWidth("🎨")},
+}};
+
+constexpr int FRUIT_KINDS = static_cast<int>(FRUIT_ARCHETYPES.size());
+
+// True if every entry sits at the index of its own enum value, and every
+// glyph is the given number of columns wide (0 for any width)
+template <typename Table>
+constexpr bool isArchetypeTable(const Table& table, int glyphWidth) {
+    for (size_t i = 0; i < table.size(); ++i) {
+        if (static_cast<size_t>(table[i].type) != i) return false;
+        if (glyphWidth > 0 && table[i].width != glyphWidth) return false;
+    }
+    return true;
+}
+static_assert(isArchetypeTable(FRUIT_ARCHETYPES, 2), "fruits must be in FruitType order, and the playfield lays them out two columns wide");
+static_assert(FRUIT_ARCHETYPES.back().type == FruitType::SPECIAL, "spawnFruit re-rolls the special fruit by leaving out the last kind");
+static_assert(isArchetypeTable(POWERUP_ARCHETYPES, 0), "power-ups must be in PowerupType order");
+static_assert(isArchetypeTable(EFFECT_ARCHETYPES, 0), "effects must be in GameEffectType order");
+
+// --- Terminal Session ---
+constexpr std::string_view ENTER_DISPLAY_MODE = "\033[?1049h\033[?25l"; // Alternate screen, hide cursor
+constexpr std::string_view LEAVE_DISPLAY_MODE = "\033[0m\033[?2026l\033[?25h\033[?1049l";
+constexpr std::string_view BEGIN_SYNCHRONIZED_UPDATE = "\033[?2026h"; // DEC mode 2026
+constexpr std::string_view END_SYNCHRONIZED_UPDATE = "\033[?2026l";
+
+// Puts the terminal into the game's mode for the lifetime of the object:
+// alternate screen, hidden cursor, and keys delivered one at a time without
+// echo. Everything is set once here rather than around every read. The
+// original state is put back on destruction, on exit(), on fatal signals
+// (including the abort of an uncaught exception) and while the game is
+// suspended with Ctrl-Z; resuming sets the game's mode up again.
+class TerminalSession {
+public:
+    TerminalSession() : active(isatty(STDOUT_FILENO)), synchronizedOutput(false) {
+        // Terminals without mode 2026 ignore it; FRUITY_SYNC_OUTPUT=0 turns it off for those that misbehave
+        const char* term = std::getenv("TERM");
+        const char* setting = std::getenv("FRUITY_SYNC_OUTPUT");
+        synchronizedOutput = active && !(term && std::string_view(term) == "dumb") && !(setting && std::string_view(setting) == "0");
+
+        ownsDisplay = active;
+        ownsKeyboard = tcgetattr(STDIN_FILENO, &savedTermios) == 0;
+        if (ownsKeyboard) {
+            rawTermios = savedTermios;
+            rawTermios.c_lflag &= ~(ICANON | ECHO); // ISIG stays on, so Ctrl-C and Ctrl-Z still raise signals
+            rawTermios.c_cc[VMIN] = 1;
+            rawTermios.c_cc[VTIME] = 0;
+        }
+        if (!ownsDisplay && !ownsKeyboard) return;
+
+        enterGameMode();
+        std::atexit(restoreTerminal);
+        struct sigaction action = {};
+        sigemptyset(&action.sa_mask);
+        action.sa_handler = handleFatalSignal;
+        for (int sig : {SIGINT, SIGTERM, SIGHUP, SIGQUIT, SIGABRT}) sigaction(sig, &action, nullptr);
+        action.sa_handler = handleStopSignal;
+        action.sa_flags = SA_RESTART;
+        sigaction(SIGTSTP, &action, nullptr);
+        action.sa_handler = handleContinueSignal;
+        sigaction(SIGCONT, &action, nullptr);
+    }
+
+    ~TerminalSession() {
+        if (!ownsDisplay && !ownsKeyboard) return;
+        signal(SIGTSTP, SIG_DFL);
+        signal(SIGCONT, SIG_DFL);
+        restoreTerminal();
+        ownsDisplay = ownsKeyboard = false;
+    }
+
+    TerminalSession(const TerminalSession&) = delete;
+    TerminalSession& operator=(const TerminalSession&) = delete;
+
+    bool supportsSynchronizedOutput() const { return synchronizedOutput; }
+
+private:
+    static void writeAll(std::string_view bytes) {
+        size_t offset = 0;
+        while (offset < bytes.size()) {
+            ssize_t n = write(STDOUT_FILENO, bytes.data() + offset, bytes.size() - offset);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return;
+            offset += static_cast<size_t>(n);
+        }
+    }
+
+    // Both are async-signal-safe and do nothing when the terminal is already in that mode
+    static void enterGameMode() {
+        if (ownsKeyboard && !keyboardModeActive.exchange(true)) tcsetattr(STDIN_FILENO, TCSANOW, &rawTermios);
+        if (ownsDisplay && !displayModeActive.exchange(true)) writeAll(ENTER_DISPLAY_MODE);
+    }
+
+    static void restoreTerminal() {
+        if (displayModeActive.exchange(false)) writeAll(LEAVE_DISPLAY_MODE);
+        if (keyboardModeActive.exchange(false)) tcsetattr(STDIN_FILENO, TCSADRAIN, &savedTermios);
+    }
+
+    static void handleFatalSignal(int sig) {
+        restoreTerminal();
+        signal(sig, SIG_DFL);
+        raise(sig);
+    }
 
-struct Achievement {
-    std::string name;
-    std::string description;
-    bool unlocked;
-    int requirement;
-};
+    // Ctrl-Z: hand the terminal back to the shell, then stop for real
+    static void handleStopSignal(int) {
+        int savedErrno = errno;
+        restoreTerminal();
+        signal(SIGTSTP, SIG_DFL);
+        sigset_t pending;
+        sigemptyset(&pending);
+        sigaddset(&pending, SIGTSTP);
+        pthread_sigmask(SIG_UNBLOCK, &pending, nullptr);
+        raise(SIGTSTP);
+        // Running again
+        struct sigaction action = {};
+        sigemptyset(&action.sa_mask);
+        action.sa_handler = handleStopSignal;
+        action.sa_flags = SA_RESTART;
+        sigaction(SIGTSTP, &action, nullptr);
+        errno = savedErrno;
+    }
 
-struct GameStats {
-    int totalFruitsCaught;
-    int totalSpecialFruitsCaught;
-    int highestCombo;
-    int totalScore;
-    int gamesPlayed;
-    std::chrono::system_clock::time_point startTime;
-    std::chrono::system_clock::time_point endTime; // For tracking game end time
-    int totalFruitsMissed;
-    int totalPowerUpsCollected;
-    int totalEffectsActivated;
+    // Also covers a stop the game never saw coming, such as SIGSTOP
+    static void handleContinueSignal(int) {
+        int savedErrno = errno;
+        enterGameMode();
+        screenLost.store(true, std::memory_order_relaxed);
+        terminalResized.store(true, std::memory_order_relaxed); // It may well have been while we were stopped
+        wakeForSignal();
+        errno = savedErrno;
+    }
+
+    static inline std::atomic<bool> displayModeActive{false};
+    static inline std::atomic<bool> keyboardModeActive{false};
+    static inline bool ownsDisplay = false;
+    static inline bool ownsKeyboard = false;
+    static inline struct termios savedTermios;
+    static inline struct termios rawTermios;
+    bool active;
+    bool synchronizedOutput;
 };
 
-struct PlayerProfile {
-    std::string name;
-    int totalGames;
-    int totalScore;
-    std::map<std::string, bool> achievements;
-    int highestLevel;
-    std::chrono::system_clock::time_point lastPlayed;
+// --- Input ---
+const size_t INPUT_QUEUE_SIZE = 256;                  // Keys buffered between the input thread and the play loop
+const std::chrono::milliseconds ESCAPE_TIMEOUT(25);   // How long an escape sequence may take to arrive in full
+
+// Bounded single-producer/single-consumer ring. Each side owns one index and
+// only reads the other's, so neither ever takes a lock.
+template <typename T, size_t Capacity>
+class SpscRing {
+    static_assert((Capacity & (Capacity - 1)) == 0, "SpscRing capacity must be a power of two");
+public:
+    SpscRing() : head(0), tail(0) {}
+
+    // Producer side. Returns false when the ring is full.
+    bool push(const T& item) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == Capacity) return false;
+        slots[t & (Capacity - 1)] = item;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side. The oldest item, or nullptr when the ring is empty.
+    const T* front() const {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) return nullptr;
+        return &slots[h & (Capacity - 1)];
+    }
+
+    void pop() { head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+    void clear() { head.store(tail.load(std::memory_order_acquire), std::memory_order_release); }
+
+private:
+    T slots[Capacity];
+    alignas(64) std::atomic<size_t> head; // Next slot to read; written by the consumer
+    alignas(64) std::atomic<size_t> tail; // Next slot to write; written by the producer
 };
 
-struct GameEffect {
-    GameEffectType type;
-    int duration;
-    std::string symbol;
-    bool active;
-    std::chrono::system_clock::time_point startTime;
-    int colorIndex;  // For Color Shift effect
-    GameEffect(GameEffectType t, int d, const std::string& s) : type(t), duration(d), symbol(s), active(false), colorIndex(0) {}
+struct InputEvent {
+    char key;                                   // Lower-case key; the arrow keys arrive as 'a' and 'd'
+    std::chrono::steady_clock::time_point time; // When the bytes were read
 };
 
-struct Powerup {
-    PowerupType type;
-    int duration;
-    std::string description;
-    bool active;
+// Turns raw terminal bytes into keys, including the escape sequences the arrow keys send
+class KeyDecoder {
+public:
+    KeyDecoder() : state(State::TEXT) {}
+
+    // Feeds one byte and returns the key it completes, or 0
+    char feed(unsigned char byte) {
+        switch (state) {
+            case State::TEXT:
+                if (byte == 0x1b) {
+                    state = State::ESCAPE;
+                    return 0;
+                }
+                return static_cast<char>(std::tolower(byte));
+            case State::ESCAPE:
+                if (byte == '[' || byte == 'O') {
+                    state = State::SEQUENCE;
+                    return 0;
+                }
+                state = State::TEXT; // A lone Escape followed by an ordinary key
+                return feed(byte);
+            case State::SEQUENCE:
+                if (byte < 0x40 || byte > 0x7e) return 0; // Parameter bytes
+                state = State::TEXT;
+                if (byte == 'D') return 'a';
+                if (byte == 'C') return 'd';
+                return 0;
+        }
+        return 0;
+    }
+
+    bool midSequence() const { return state != State::TEXT; }
+    void reset() { state = State::TEXT; }
+
+private:
+    enum class State { TEXT, ESCAPE, SEQUENCE };
+    State state;
 };
 
-struct Particle {
-    int x, y;
-    ParticleType type;
-    std::string symbol;
-    int lifetime;
-    double velocity_x;
-    double velocity_y;
-    int color;
-    std::chrono::system_clock::time_point creationTime;
+// Reads the keyboard on its own thread for the length of a game. It blocks in
+// poll(2) on stdin, decodes whatever one read returns and queues every key with
+// the time it arrived, so the play loop picks keys up without a syscall.
+class InputThread {
+public:
+    InputThread() : running(false), wakeFds{-1, -1}, readyFds{-1, -1} {}
+    ~InputThread() { stop(); }
+
+    void start();
+    void stop();
+
+    // Consumer side, for the play loop
+    const InputEvent* front() const { return queue.front(); }
+    void pop() { queue.pop(); }
+    void waitForKey(int alsoWakeFd);
+
+private:
+    void readLoop();
+    void enqueue(const InputEvent& event);
+
+    SpscRing<InputEvent, INPUT_QUEUE_SIZE> queue;
+    std::thread thread;
+    std::atomic<bool> running;
+    int wakeFds[2];  // Self-pipe that gets the thread out of poll() on stop
+    int readyFds[2]; // Written after every queued key, for a consumer blocked in waitForKey()
 };
 
-struct ShopItem {
-    ShopItemType type;
-    std::string name;
-    std::string description;
-    int price;
-    bool unlocked;
-    std::string preview;
+void InputThread::start() {
+    if (running.load()) return;
+    if (pipe(wakeFds) < 0) wakeFds[0] = wakeFds[1] = -1;
+    if (pipe(readyFds) < 0) {
+        readyFds[0] = readyFds[1] = -1;
+    } else {
+        for (int fd : readyFds) fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    }
+    queue.clear();
+    running.store(true);
+    thread = std::thread(&InputThread::readLoop, this);
+}
+
+void InputThread::stop() {
+    if (!running.exchange(false)) return;
+    if (wakeFds[1] >= 0) {
+        ssize_t written = write(wakeFds[1], "x", 1);
+        (void)written; // Should it fail, the thread still notices on the next key
+    }
+    thread.join();
+    for (int* fds : {wakeFds, readyFds}) {
+        for (int i = 0; i < 2; i++) {
+            if (fds[i] >= 0) close(fds[i]);
+            fds[i] = -1;
+        }
+    }
+}
+
+// Blocks until a key is queued or `alsoWakeFd` becomes readable, without
+// consuming anything
+void InputThread::waitForKey(int alsoWakeFd) {
+    char bytes[64];
+    while (readyFds[0] >= 0 && read(readyFds[0], bytes, sizeof(bytes)) > 0) {
+    }
+    // A key queued after this check has also written to the pipe, so poll() sees it
+    if (queue.front() || readyFds[0] < 0) return;
+    struct pollfd fds[2] = {{readyFds[0], POLLIN, 0}, {alsoWakeFd, POLLIN, 0}};
+    while (poll(fds, alsoWakeFd >= 0 ? 2 : 1, -1) < 0 && errno == EINTR) {
+    }
+}
+
+void InputThread::readLoop() {
+    KeyDecoder decoder;
+    struct pollfd fds[2] = {{STDIN_FILENO, POLLIN, 0}, {wakeFds[0], POLLIN, 0}};
+    unsigned char bytes[64];
+    while (running.load(std::memory_order_acquire)) {
+        // An unfinished escape sequence gets a moment to complete before it is dropped as a lone Escape
+        int timeout = decoder.midSequence() ? static_cast<int>(ESCAPE_TIMEOUT.count()) : -1;
+        int ready = poll(fds, wakeFds[0] >= 0 ? 2 : 1, timeout);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (ready == 0) {
+            decoder.reset();
+            continue;
+        }
+        if (fds[1].revents) break;
+        ssize_t count = read(STDIN_FILENO, bytes, sizeof(bytes));
+        if (count < 0 && errno == EINTR) continue;
+        if (count <= 0) break; // End of input
+        auto now = std::chrono::steady_clock::now();
+        for (ssize_t i = 0; i < count; i++) {
+            if (char key = decoder.feed(bytes[i])) enqueue({key, now});
+        }
+    }
+}
+
+// A full queue means the play loop has stalled; wait for room rather than lose the key
+void InputThread::enqueue(const InputEvent& event) {
+    while (!queue.push(event)) {
+        if (!running.load(std::memory_order_acquire)) return;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    if (readyFds[1] >= 0) {
+        ssize_t written = write(readyFds[1], "k", 1);
+        (void)written; // A full pipe already wakes the consumer
+    }
+}
+
+// --- Instrumentation ---
+// Log-linear latency histogram in the style of HdrHistogram: exact below
+// 128 ns, then 64 sub-buckets per power of two (under 1.6% error) across the
+// whole 64-bit range. Recording is a couple of shifts and a counter bump.
+// One thread records; others may read while it does, and then see a count or
+// two in flight.
+class LatencyHistogram {
+public:
+    LatencyHistogram() { reset(); }
+
+    void record(uint64_t nanoseconds) {
+        auto& bucket = counts[bucketIndex(nanoseconds)];
+        bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        total.store(total.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        if (nanoseconds > maximum.load(std::memory_order_relaxed)) maximum.store(nanoseconds, std::memory_order_relaxed);
+    }
+
+    void reset() {
+        for (auto& bucket : counts) bucket.store(0, std::memory_order_relaxed);
+        total.store(0, std::memory_order_relaxed);
+        maximum.store(0, std::memory_order_relaxed);
+    }
+
+    uint64_t count() const { return total.load(std::memory_order_relaxed); }
+    uint64_t max() const { return maximum.load(std::memory_order_relaxed); }
+
+    // Smallest recorded value that at least `fraction` of all samples do not exceed,
+    // reported as the top of its bucket
+    uint64_t percentile(double fraction) const {
+        uint64_t samples = count();
+        if (samples == 0) return 0;
+        uint64_t target = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(fraction * samples)));
+        uint64_t seen = 0;
+        for (int i = 0; i < BUCKETS; i++) {
+            seen += counts[i].load(std::memory_order_relaxed);
+            if (seen >= target) return std::min(highestValueIn(i), max());
+        }
+        return max();
+    }
+
+private:
+    static constexpr int SUB_BUCKET_BITS = 6;
+    static constexpr int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static constexpr int BUCKETS = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    static int bucketIndex(uint64_t value) {
+        if (value < 2 * SUB_BUCKETS) return static_cast<int>(value);
+        int shift = (63 - __builtin_clzll(value)) - SUB_BUCKET_BITS;
+        return shift * SUB_BUCKETS + static_cast<int>(value >> shift);
+    }
+
+    static uint64_t highestValueIn(int index) {
+        if (index < 2 * SUB_BUCKETS) return index;
+        int shift = index / SUB_BUCKETS - 1;
+        uint64_t subBucket = index - shift * SUB_BUCKETS;
+        return ((subBucket + 1) << shift) - 1;
+    }
+
+    std::array<std::atomic<uint64_t>, BUCKETS> counts;
+    std::atomic<uint64_t> total;
+    std::atomic<uint64_t> maximum;
 };
 
-struct AchievementTier {
-    std::string name;
-    int requirement;
-    bool claimed;
-    std::string reward;
+// Timed phases of the play loop; the indented ones are parts of updateGameLogic
+enum Phase : uint8_t {
+    PHASE_INPUT, PHASE_SPAWN, PHASE_UPDATE, PHASE_PARTICLES, PHASE_TIMERS, PHASE_POWERUP,
+    PHASE_CHALLENGES, PHASE_ACHIEVEMENTS, PHASE_SLEEP, PHASE_DRAW, PHASE_COUNT
 };
+constexpr std::string_view PHASE_NAMES[PHASE_COUNT] = {
+    "input", "spawnFruit", "updateGameLogic", "  updateParticles", "  timers", "  applyPowerup",
+    "  updateChallenges", "  checkAchievements", "sleep", "drawGame"
+};
+const std::string PHASE_REPORT_FILE = "phase_times.txt";
 
-// Structure for game challenges
-struct Challenge {
-    ChallengeType type;
-    std::string description;
-    bool active;
-    int target;
-    int progress;
-    std::chrono::system_clock::time_point startTime;
+// One histogram per phase. drawGame is recorded by the render thread, the
+// rest by the simulation thread.
+struct PhaseTimes {
+    bool enabled = true;
+    std::array<LatencyHistogram, PHASE_COUNT> phases;
 
-    Challenge(ChallengeType type) : type(type), active(false), progress(0) {
-        switch (type) {
-            case ChallengeType::SPEED_CHALLENGE:
-                description = "Catch 50 fruits in under 60 seconds";
-                target = 50;
-                break;
-            case ChallengeType::COMBO_CHALLENGE:
-                description = "Achieve a combo of 30";
-                target = 30;
-                break;
-            case ChallengeType::ACCURACY_CHALLENGE:
-                description = "Catch 100 fruits without missing more than 5";
-                target = 100;
-                break;
-            case ChallengeType::SURVIVAL_CHALLENGE:
-                description = "Survive for 120 seconds";
-                target = 120;
-                break;
-            case ChallengeType::COLOR_CHALLENGE:
-                description = "Catch 20 red fruits in a row";
-                target = 20;
-                break;
-            default:
-                description = "Unknown Challenge";
-                target = 0;
-        }
+    void reset() {
+        for (auto& phase : phases) phase.reset();
+    }
+};
+
+// Times the enclosing scope into one phase's histogram; does nothing while timing is off
+class PhaseTimer {
+public:
+    PhaseTimer(PhaseTimes& times, Phase phase)
+        : histogram(times.enabled ? &times.phases[phase] : nullptr),
+          start(histogram ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point()) {}
+    ~PhaseTimer() {
+        if (histogram) histogram->record(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
     }
+    PhaseTimer(const PhaseTimer&) = delete;
+    PhaseTimer& operator=(const PhaseTimer&) = delete;
+
+private:
+    LatencyHistogram* histogram;
+    std::chrono::steady_clock::time_point start;
 };
 
+// Set from the SIGUSR1 handler; the play loop writes the phase report to PHASE_REPORT_FILE when it sees it
+std::atomic<bool> phaseReportRequested(false);
+
 // --- Function Prototypes ---
-int kbhit();
-char getch();
-void clearScreen();
+// What getch() returns besides a key
+const int KEY_REDRAW = -1;        // A signal asked for the screen to be drawn again
+const int KEY_END_OF_INPUT = -2;  // stdin is closed; no key will ever come
+
+int getch();
+bool queryTerminalSize(int& columns, int& rows);
+void installResizeHandler();
+void installPhaseReportHandler();
 std::string getCurrentTimestamp();
+std::string formatPhaseReport(const PhaseTimes& times);
 
 // --- Game Class ---
 class Game {
@@ -186,12 +1893,14 @@ private:
     int score;
     int lives;
     int level;
-    int gameSpeed;
-    std::vector<Fruit> fruits;
+    double gameSpeed; // Fall speed in rows per second
     std::vector<Basket> baskets;
-    Fruit* currentFruit;
-    int fruitY;
-    int fruitX;
+    BasketIndex basketIndex;
+    FruitPool fallingFruits; // Every fruit on the playfield
+    int screenWidth;  // Playfield size, follows the terminal
+    int screenHeight;
+    int terminalColumns; // Terminal size as of the last layout, 0 if unknown
+    int terminalRows;
     std::vector<int> highScores;
     int combo;
     int maxCombo;
@@ -212,158 +1921,250 @@ private:
     bool isPaused;
     int comboMultiplier;
     int consecutiveCatches;
-    std::chrono::system_clock::time_point lastScoreTime;
-    std::chrono::system_clock::time_point lastPowerupTime;
+    SimClock::time_point lastScoreTime;
+    SimClock::time_point lastPowerupTime;
     int totalFruits;
-    std::mt19937 randomEngine;
+    // One seed drives every random decision, split into independent streams
+    // so that e.g. drawing more particles never changes which fruit comes next
+    uint64_t seed;
+    uint64_t gamesStarted; // Game n of a session is seeded with gameSeedFor(n), so it can be replayed on its own
+    uint64_t gameSeed;
+    Rng spawnRng;    // Fruit type and position
+    Rng effectRng;   // Power-ups, effects, bonus mode and challenges
+    Rng cosmeticRng; // Particles, colours and screen shake
     GameState currentState;
-    std::vector<Particle> particles;
+    ParticleSystem particles;
     std::vector<ShopItem> shopItems;
     std::map<std::string, std::vector<AchievementTier>> tieredAchievements;
     int selectedTheme;
     bool musicEnabled;
     bool effectsEnabled;
+    int frameRateIndex; // Into FRAME_RATES; render cadence is independent of the logic tick
     int coins;
     std::string currentBackground;
     std::vector<std::string> unlockedBackgrounds;
     std::vector<std::string> unlockedBasketSkins;
-    double gravity;
     std::vector<std::pair<std::string, int>> floatingTexts;
     std::vector<std::pair<int, int>> sparkles;
-    int screenShakeIntensity;
     bool rainbowMode;
     int dailyStreak;
     std::time_t lastPlayTime;
     int specialFruitSpawnTimer;
     std::vector<Challenge> challenges; // In-game challenges
     bool bonusModeActive;
-    int bonusModeTimer;
+    uint64_t bonusModeTimer; // TimerQueue id of the timer that ends bonus mode
     std::map<FruitType, int> fruitsCaughtByType;
     std::vector<int> scoreHistory;
     int longestStreak;
     int totalPlayTime;
-    std::chrono::system_clock::time_point lastBonusTime;
-    std::chrono::system_clock::time_point lastChallengeTime;
+    TimerQueue timers; // Everything that happens at a set game time
+    SimClock::time_point simTime;      // Advanced only by updateGameLogic()
+    SimClock::time_point nextRuleStep; // When the per-step rules next run
+    int tickRate;                      // Simulation ticks per second
+    uint64_t gameTicks;                // Ticks since the current game started
+    std::chrono::steady_clock::time_point tickStart; // Wall time the newest tick stands for
     bool freezeTime; // Added for the new powerup effect
     const std::vector<std::string> BORDER_STYLES = { "═║╔╗╚╝", "═║╔╗╚╝", "─│┌┐└┘", "━┃┏┓┗┛" };
+    GlyphTable glyphs;
+    std::array<uint16_t, FRUIT_KINDS> fruitGlyphs; // Interned glyph of each fruit archetype
+    FrameBuffer frame;       // In-game screen, diffed against the terminal each frame
+    OutputArena output;      // Every screen is composed here and written out in one go; owned by the render thread during play
+    RenderStats renderStats;
+    PhaseTimes phaseTimes;   // Where each tick and frame spends its time
+    InputThread input;       // Keyboard reader while a game is being played
+    PlayfieldRaster raster;
+    HudWidgets hud;
+    std::pair<int, int> tooSmallNotice; // Terminal size the "too small" notice was drawn for; render thread only
+    TripleBuffer<RenderSnapshot> snapshots; // Simulation -> render thread hand-off
+    uint64_t snapshotSequence;
+    std::thread renderThread;
+    std::atomic<bool> renderThreadRunning;
+    std::mutex snapshotMutex;                 // Only for the render thread's wait; snapshots themselves are lock-free
+    std::condition_variable snapshotPublished;
+    bool synchronizedOutput; // Bracket each frame so the terminal repaints it atomically
+    std::string recordPath;  // Where each finished game is recorded, empty if not recording
+    Replay recording;        // The game in progress, while recording
+    std::string recordStatus;
 
     // Initialization Functions
-    void initializeFruits();
     void initializeBaskets();
+    const BasketIndex& currentBasketIndex();
     void initializeAchievements();
     void initializeAnimations();
     void initializeEffects();
+    void initializeGlyphs();
     void loadHighScores();
     void saveHighScore(int score);
 
     // Drawing Functions
     void drawGameBorder();
-    void drawPowerupStatus();
-    void drawCombo();
-    void drawGame();
+    void drawPowerupStatus(const RenderSnapshot& view, int row);
+    void drawCombo(const RenderSnapshot& view, int row);
+    void drawGame(const RenderSnapshot& view);
+    void drawTerminalTooSmall(const RenderSnapshot& view, int columns, int rows);
+    void rasterizePlayfield(const RenderSnapshot& view, double alpha);
+    void publishSnapshot();
+    void startRenderThread();
+    void stopRenderThread();
+    void renderLoop();
     void drawMenu();
     void drawInstructions();
     void drawHighScores();
     void drawGameOver();
     void drawGameStats();
-    void drawProgressBar();
+    void drawProgressBar(const RenderSnapshot& view, int row);
     void drawGameMessages();
-    void drawEffects();
-    void printCenteredText(const std::string& text, int y);
+    void drawEffects(const RenderSnapshot& view, int row);
+    void printText(std::string_view text, int x, int y);
+    void printCenteredText(std::string_view text, int y);
+    // Terminal size the menu screens are laid out in; the default frame's when it is unknown
+    int menuColumns() const { return terminalColumns > 0 ? terminalColumns : SCREEN_WIDTH + 2; }
+    int menuRows() const { return terminalRows > 0 ? terminalRows : SCREEN_HEIGHT + 1 + HUD_STATUS_ROWS; }
+    void clearScreen();
+    int presentOutput();
     void drawScoreBoard();
     void displayShop();
+    void buyShopItem(char key);
     void drawSettings(); // 新增遊戲設定選項
+    void changeSetting(char choice);
 
     // Game Logic Functions
     void spawnFruit();
+    int fruitLimit() const;
+    void landFruit(int slot);
     void updateGameSpeed();
     void checkAchievements();
     void updateGameLogic();
+    void updateRules();
+    std::chrono::nanoseconds tickPeriod() const { return std::chrono::nanoseconds(1000000000 / tickRate); }
     void applyPowerup();
+    void endPowerup();
     void updateAnimation();
     void addGameMessage(const std::string& message);
-    void updateEffects();
+    void startEffect(size_t index, int seconds);
     void activateRandomEffect();
     void manageRecentScores();
     void resetGame();
     void updateFruitVelocity();
-
+    void updateLayout();
+    void resizePlayfield(int newWidth, int newHeight);
+    void seedGame(uint64_t newGameSeed);
+    uint64_t gameSeedFor(uint64_t index) const;
+    void applyInput(char input);
+    void recordEvent(char key);
+    size_t applyReplayEvents(const Replay& replay, size_t next);
+    void playLoop(const Replay* playback);
+    void drainInput(const Replay* playback, std::chrono::steady_clock::time_point until);
+    GameOutcome currentOutcome() const;
     // Additional functions for enhanced gameplay
     void handleLevelProgression();
+    void scheduleBonusMode(SimClock::time_point when);
     void activateBonusMode();
-    void updateBonusMode();
+    void scheduleChallenge(SimClock::time_point when);
     void triggerChallenge();
     void updateChallenges();
     void updateParticles();
     void addParticles(int x, int y, ParticleType type, int num, int color = -1);
-    void applyScreenShake();
     void applyFreezeTime(); // Implementation for the new powerup effect
-    void startNewGame();
+    void startNewGame(uint64_t newGameSeed);
 
     // Utility Functions
-    std::string colorCode(int color);
+    std::string_view colorCode(int color);
     int generateRandomColor();
     void updateAchievementsProgress(const std::string& achievementName, int increment);
     void unlockAchievement(const std::string& achievementName);
 
 public:
-    Game();
+    explicit Game(bool headless = false);
+    void attachTerminal();
     void run();
-    ~Game() { delete currentFruit; }
+    void playHeadlessGames(uint64_t first, uint64_t count, HeadlessReport& report);
+    void setSynchronizedOutput(bool enabled) { synchronizedOutput = enabled; }
+    void setTickRate(int rate) { tickRate = std::clamp(rate, MIN_TICK_RATE, MAX_TICK_RATE); }
+    int getTickRate() const { return tickRate; }
+    void setSeed(uint64_t newSeed);
+    uint64_t getSeed() const { return seed; }
+    void setRecordPath(const std::string& path) { recordPath = path; }
+    GameOutcome playReplay(const Replay& replay, bool headless);
+    ~Game() {
+        stopRenderThread();
+    }
 };
 
 // --- Non-member Functions ---
-int kbhit() {
-    struct termios oldt, newt;
-    int ch;
-    int oldf;
+// Blocks for one key and returns it as an unsigned byte. The TerminalSession
+// has already made the terminal deliver keys unbuffered and without echo.
+// Returns KEY_REDRAW instead when a signal (resize, resume) means the screen
+// should be drawn again, and KEY_END_OF_INPUT once stdin is closed.
+int getch() {
+    struct pollfd fds[2] = {{STDIN_FILENO, POLLIN, 0}, {signalWakeFds[0], POLLIN, 0}};
+    while (poll(fds, signalWakeFds[0] >= 0 ? 2 : 1, -1) < 0 && errno == EINTR) {
+    }
+    if (fds[1].revents & POLLIN) {
+        drainSignalWakes();
+        return KEY_REDRAW;
+    }
+    unsigned char buf = 0;
+    ssize_t count;
+    while ((count = read(STDIN_FILENO, &buf, 1)) < 0 && errno == EINTR) {
+    }
+    return count == 1 ? buf : KEY_END_OF_INPUT; // A hangup or a closed pipe reads as 0 bytes
+}
 
-    tcgetattr(STDIN_FILENO, &oldt);
-    newt = oldt;
-    newt.c_lflag &= ~(ICANON | ECHO);
-    tcsetattr(STDIN_FILENO, TCSANOW, &newt);
-    oldf = fcntl(STDIN_FILENO, F_GETFL, 0);
-    fcntl(STDIN_FILENO, F_SETFL, oldf | O_NONBLOCK);
+bool queryTerminalSize(int& columns, int& rows) {
+    struct winsize size;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) < 0 || size.ws_col == 0 || size.ws_row == 0) return false;
+    columns = size.ws_col;
+    rows = size.ws_row;
+    return true;
+}
 
-    ch = getchar();
+void handleResizeSignal(int) {
+    int savedErrno = errno;
+    terminalResized.store(true, std::memory_order_relaxed);
+    wakeForSignal();
+    errno = savedErrno;
+}
 
-    tcsetattr(STDIN_FILENO, TCSANOW, &oldt);
-    fcntl(STDIN_FILENO, F_SETFL, oldf);
+void installResizeHandler() {
+    struct sigaction action = {};
+    action.sa_handler = handleResizeSignal;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    sigaction(SIGWINCH, &action, nullptr);
+}
 
-    if(ch != EOF) {
-        ungetc(ch, stdin);
-        return 1;
-    }
+void handlePhaseReportSignal(int) {
+    int savedErrno = errno;
+    phaseReportRequested.store(true, std::memory_order_relaxed);
+    wakeForSignal();
+    errno = savedErrno;
+}
 
-    return 0;
+// kill -USR1 <pid> asks a running game for its phase timings
+void installPhaseReportHandler() {
+    struct sigaction action = {};
+    action.sa_handler = handlePhaseReportSignal;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    sigaction(SIGUSR1, &action, nullptr);
 }
 
-char getch() {
-    char buf = 0;
-    struct termios old = {0};
-    if (tcgetattr(0, &old) < 0)
-        perror("tcsetattr()");
-    old.c_lflag &= ~ICANON;
-    old.c_lflag &= ~ECHO;
-    old.c_cc[VMIN] = 1;
-    old.c_cc[VTIME] = 0;
-    if (tcsetattr(0, TCSANOW, &old) < 0)
-        perror("tcsetattr ICANON");
-    if (read(0, &buf, 1) < 0)
-        perror ("read()");
-    old.c_lflag |= ICANON;
-    old.c_lflag |= ECHO;
-    if (tcsetattr(0, TCSADRAIN, &old) < 0)
-        perror ("tcsetattr ~ICANON");
-    return (buf);
-}
-
-void clearScreen() {
-    #ifdef _WIN32
-        system("cls");
-    #else
-        system("clear");
-    #endif
+// Count and p50/p99/p99.9/max per phase, in microseconds
+std::string formatPhaseReport(const PhaseTimes& times) {
+    std::string report;
+    char line[128];
+    std::snprintf(line, sizeof(line), "%-20s %9s %9s %9s %9s %9s\n", "phase (us)", "count", "p50", "p99", "p99.9", "max");
+    report += line;
+    for (int i = 0; i < PHASE_COUNT; i++) {
+        const LatencyHistogram& h = times.phases[i];
+        if (h.count() == 0) continue;
+        std::snprintf(line, sizeof(line), "%-20s %9llu %9.1f %9.1f %9.1f %9.1f\n", std::string(PHASE_NAMES[i]).c_str(),
+                      static_cast<unsigned long long>(h.count()), h.percentile(0.5) / 1000.0,
+                      h.percentile(0.99) / 1000.0, h.percentile(0.999) / 1000.0, h.max() / 1000.0);
+        report += line;
+    }
+    return report;
 }
 
 std::string getCurrentTimestamp() {
@@ -378,41 +2179,125 @@ std::string getCurrentTimestamp() {
     return ss.str();
 }
 
+// Replay files are plain text. The input log is one token per event: the
+// number of ticks since the previous event followed by the key, e.g. "12a".
+const std::string REPLAY_MAGIC = "fruity-replay";
+const int REPLAY_VERSION = 5; // Bumped whenever the simulation changes, since old replays would no longer match
+
+bool saveReplay(const std::string& path, const Replay& replay) {
+    std::ofstream file(path);
+    if (!file.is_open()) return false;
+    file << REPLAY_MAGIC << ' ' << REPLAY_VERSION << '\n';
+    file << "seed " << replay.seed << " tick_rate " << replay.tickRate << " width " << replay.width
+         << " height " << replay.height << " difficulty " << replay.difficulty << '\n';
+    file << "events " << replay.events.size() << '\n';
+    uint64_t lastTick = 0;
+    for (size_t i = 0; i < replay.events.size(); ++i) {
+        const auto& event = replay.events[i];
+        file << (event.tick - lastTick) << event.key;
+        if (event.key == 'r') file << event.width << 'x' << event.height;
+        file << ((i + 1) % 32 == 0 ? '\n' : ' ');
+        lastTick = event.tick;
+    }
+    const GameOutcome& o = replay.outcome;
+    file << "\noutcome ticks " << o.ticks << " score " << o.score << " level " << o.level << " lives " << o.lives
+         << " max_combo " << o.maxCombo << " caught " << o.fruitsCaught << " special " << o.specialFruitsCaught
+         << " missed " << o.fruitsMissed << " power_ups " << o.powerUpsCollected << " effects " << o.effectsActivated << '\n';
+    return static_cast<bool>(file);
+}
+
+// True for a playfield size the game can be laid out in
+bool isPlayfieldSize(int width, int height) {
+    return width >= MIN_SCREEN_WIDTH && width <= MAX_SCREEN_WIDTH && height >= MIN_SCREEN_HEIGHT && height <= MAX_SCREEN_HEIGHT;
+}
+
+// Reads a replay written by saveReplay. Anything the game could not be set
+// up from, such as a playfield size or tick rate out of range, fails the load.
+bool loadReplay(const std::string& path, Replay& replay) {
+    std::ifstream file(path);
+    std::string magic, label;
+    int version = 0;
+    if (!(file >> magic >> version) || magic != REPLAY_MAGIC || version != REPLAY_VERSION) return false;
+    size_t count = 0;
+    if (!(file >> label >> replay.seed >> label >> replay.tickRate >> label >> replay.width >> label >> replay.height
+               >> label >> replay.difficulty >> label >> count)) {
+        return false;
+    }
+    if (replay.difficulty < 0 || replay.difficulty >= static_cast<int>(DIFFICULTY_LEVELS.size())) return false;
+    if (replay.tickRate < MIN_TICK_RATE || replay.tickRate > MAX_TICK_RATE) return false;
+    if (!isPlayfieldSize(replay.width, replay.height)) return false;
+    replay.events.clear();
+    uint64_t tick = 0;
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t delta;
+        Replay::Event event = {0, 0, 0, 0};
+        if (!(file >> delta >> event.key)) return false;
+        if (event.key == 'r') {
+            char separator;
+            if (!(file >> event.width >> separator >> event.height) || separator != 'x') return false;
+            if (!isPlayfieldSize(event.width, event.height)) return false;
+        } else if (std::string_view("adpq").find(event.key) == std::string_view::npos) {
+            return false;
+        }
+        tick += delta;
+        event.tick = tick;
+        replay.events.push_back(event);
+    }
+    GameOutcome& o = replay.outcome;
+    return static_cast<bool>(file >> label >> label >> o.ticks >> label >> o.score >> label >> o.level >> label >> o.lives
+                                  >> label >> o.maxCombo >> label >> o.fruitsCaught >> label >> o.specialFruitsCaught
+                                  >> label >> o.fruitsMissed >> label >> o.powerUpsCollected >> label >> o.effectsActivated);
+}
+
 // --- Game Class Implementation ---
 
-Game::Game() : running(true), score(0), lives(MAX_LIVES), level(1), gameSpeed(150),
-             currentFruit(nullptr), fruitY(0), fruitX(SCREEN_WIDTH / 2),
+// A headless game never touches the terminal: it keeps the default
+// playfield size and does not listen for resizes. A replay shown in the
+// terminal attaches to it afterwards.
+Game::Game(bool headless) : running(true), score(0), lives(MAX_LIVES), level(1), gameSpeed(1000.0 / 150),
+             screenWidth(SCREEN_WIDTH), screenHeight(SCREEN_HEIGHT), terminalColumns(0), terminalRows(0),
              combo(0), maxCombo(0), animationFrame(0), showTutorial(true),
              hasPowerup(false), playerName("Player"), difficultyLevel(0), isPaused(false),
-             comboMultiplier(1), consecutiveCatches(0), totalFruits(0), randomEngine(std::random_device{}()),
+             comboMultiplier(1), consecutiveCatches(0), totalFruits(0),
              currentState(GameState::MENU), selectedTheme(0), musicEnabled(true), effectsEnabled(true),
-             coins(0), currentBackground("Default"), gravity(GRAVITY_ACCELERATION),
-             screenShakeIntensity(0), rainbowMode(false), dailyStreak(0), specialFruitSpawnTimer(0),
-             bonusModeActive(false), bonusModeTimer(0), longestStreak(0), totalPlayTime(0), freezeTime(false) {
-    // Seed the random number generator
-    srand(static_cast<unsigned int>(time(0)));
+             frameRateIndex(DEFAULT_FRAME_RATE_INDEX),
+             coins(0), currentBackground("Default"),
+             rainbowMode(false), dailyStreak(0), specialFruitSpawnTimer(0),
+             bonusModeActive(false), bonusModeTimer(0), longestStreak(0), totalPlayTime(0),
+             simTime(), nextRuleStep(), tickRate(DEFAULT_TICK_RATE), gameTicks(0), freezeTime(false),
+             frame(glyphs, SCREEN_WIDTH + 2, SCREEN_HEIGHT + 1), output(1 << 16), renderStats{0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+             tooSmallNotice(0, 0), snapshotSequence(0), renderThreadRunning(false), synchronizedOutput(false) {
+    // Seed the random number generators; --seed replaces this with a fixed seed
+    setSeed(randomSeed());
 
-    initializeFruits();
+    phaseTimes.enabled = false; // Batch games run too fast for the clock reads to be worth it
+    if (!headless) {
+        attachTerminal();
+        updateLayout();
+    }
     initializeBaskets();
     initializeAchievements();
     initializeAnimations();
     initializeEffects();
-    loadHighScores();
-    stats = {0, 0, 0, 0, 0, std::chrono::system_clock::now(),std::chrono::system_clock::now(), 0, 0, 0};
-    lastScoreTime = std::chrono::system_clock::now();
+    initializeGlyphs();
+    stats = {0, 0, 0, 0, 0, simTime, simTime, 0, 0, 0};
+    lastScoreTime = simTime;
     lastPlayTime = std::time(nullptr);
-    lastBonusTime = std::chrono::system_clock::now();
-    lastChallengeTime = std::chrono::system_clock::now();
 
     // Initialize challenges
     for (int i = 0; i < 3; ++i) { // Select 3 random challenges
-        std::uniform_int_distribution<> dist(0, static_cast<int>(ChallengeType::COLOR_CHALLENGE));
-        ChallengeType type = static_cast<ChallengeType>(dist(randomEngine));
+        ChallengeType type = static_cast<ChallengeType>(effectRng.range(0, static_cast<int>(ChallengeType::COLOR_CHALLENGE)));
         challenges.emplace_back(type);
     }
 }
 
-void Game::startNewGame() {
+// Everything the simulation depends on is reset here, so a game plays out
+// the same from the same seed and input no matter what was played before it.
+void Game::startNewGame(uint64_t newGameSeed) {
+    seedGame(newGameSeed);
+    gameTicks = 0;
+    nextRuleStep = simTime;
+    specialFruitSpawnTimer = 0;
     // Reset game statistics and states
     score = 0;
     lives = MAX_LIVES;
@@ -422,33 +2307,34 @@ void Game::startNewGame() {
     consecutiveCatches = 0;
     comboMultiplier = 1;
     totalFruits = 0;
-    gameSpeed = std::max(20, 250 - (level * 10) - (difficultyLevel * 25));
-    fruitY = 0;
-    fruitX = SCREEN_WIDTH / 2;
+    gameSpeed = 1000.0 / std::max(20, 250 - (level * 10) - (difficultyLevel * 25));
+    fallingFruits.clear();
     stats.totalFruitsCaught = 0;
     stats.totalSpecialFruitsCaught = 0;
     stats.totalFruitsMissed = 0;
     stats.totalPowerUpsCollected = 0;
     stats.totalEffectsActivated = 0;
-    stats.startTime = std::chrono::system_clock::now();
+    stats.startTime = simTime;
     stats.endTime = stats.startTime; // Reset end time as well
     isPaused = false;
     bonusModeActive = false;
     bonusModeTimer = 0;
     freezeTime = false;
+    hasPowerup = false;
+    particles.clear();
+    timers.clear();
+    scheduleBonusMode(simTime + std::chrono::seconds(BONUS_INTERVAL));
+    scheduleChallenge(simTime + std::chrono::seconds(CHALLENGE_INTERVAL));
+    renderStats = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+    phaseTimes.reset();
 
-    // Clear existing fruits and reset baskets
-    if (currentFruit) {
-        delete currentFruit;
-        currentFruit = nullptr;
-    }
+    // Reset baskets
     initializeBaskets();
 
     // Reset or reinitialize challenges
     challenges.clear();
     for (int i = 0; i < 3; ++i) {
-        std::uniform_int_distribution<> dist(0, static_cast<int>(ChallengeType::COLOR_CHALLENGE));
-        ChallengeType type = static_cast<ChallengeType>(dist(randomEngine));
+        ChallengeType type = static_cast<ChallengeType>(effectRng.range(0, static_cast<int>(ChallengeType::COLOR_CHALLENGE)));
         challenges.emplace_back(type);
     }
 
@@ -456,6 +2342,7 @@ void Game::startNewGame() {
     for (auto& effect : activeEffects) {
         effect.active = false;
         effect.duration = 0;
+        effect.timer = 0;
     }
 
     // Additional resets as needed...
@@ -463,70 +2350,124 @@ void Game::startNewGame() {
     // Change game state to PLAYING
     currentState = GameState::PLAYING;
     running = true;
+
+    if (!recordPath.empty()) {
+        recording = Replay();
+        recording.seed = gameSeed;
+        recording.tickRate = tickRate;
+        recording.width = screenWidth;
+        recording.height = screenHeight;
+        recording.difficulty = difficultyLevel;
+    }
 }
 
 // Enum conversion functions
 std::string powerupTypeToString(PowerupType type) {
-    switch(type) {
-        case PowerupType::DOUBLE_POINTS: return "Double Points";
-        case PowerupType::SLOW_MOTION: return "Slow Motion";
-        case PowerupType::EXTRA_LIFE: return "Extra Life";
-        case PowerupType::MAGNET: return "Magnet";
-        case PowerupType::SCORE_BOOST: return "Score Boost";
-        case PowerupType::FREEZE_TIME: return "Freeze Time";
-        default: return "Unknown";
-    }
+    return std::string(POWERUP_ARCHETYPES[static_cast<int>(type)].name);
+}
+
+std::string_view powerupSymbol(PowerupType type) {
+    return POWERUP_ARCHETYPES[static_cast<int>(type)].glyph;
 }
 
 std::string gameEffectTypeToString(GameEffectType type) {
-    switch(type) {
-        case GameEffectType::SPEED_BOOST: return "Speed Boost";
-        case GameEffectType::SHIELD: return "Shield";
-        case GameEffectType::DOUBLE_SCORE: return "Double Score";
-        case GameEffectType::MAGNET: return "Magnet";
-        case GameEffectType::INVISIBILITY: return "Invisibility";
-        case GameEffectType::COLOR_SHIFT: return "Color Shift";
-        default: return "Unknown";
-    }
+    return std::string(EFFECT_ARCHETYPES[static_cast<int>(type)].name);
 }
 
-std::string Game::colorCode(int color) {
-    // Color codes for different platforms and terminals
-    switch (color) {
-        case 0: return "\033[30m"; // Black
-        case 1: return "\033[31m"; // Red
-        case 2: return "\033[32m"; // Green
-        case 3: return "\033[33m"; // Yellow
-        case 4: return "\033[34m"; // Blue
-        case 5: return "\033[35m"; // Magenta
-        case 6: return "\033[36m"; // Cyan
-        case 7: return "\033[37m"; // White
-        default: return "\033[0m";  // Reset
-    }
+std::string_view gameEffectSymbol(GameEffectType type) {
+    return EFFECT_ARCHETYPES[static_cast<int>(type)].glyph;
+}
+
+std::string_view Game::colorCode(int color) {
+    return (color >= 0 && color < 8) ? SGR_COLORS[color] : SGR_RESET;
 }
 
 int Game::generateRandomColor() {
-    return rand() % 8;
+    return static_cast<int>(cosmeticRng.below(8));
+}
+
+// Seeds the session. Every game draws its own seed from it, so a session is
+// reproducible from its seed and the input it received.
+void Game::setSeed(uint64_t newSeed) {
+    seed = newSeed;
+    gamesStarted = 0;
+    seedGame(seed);
+}
+
+// Depends only on the session seed and the game's index, so a batch run
+// plays the same games however they are spread over threads
+uint64_t Game::gameSeedFor(uint64_t index) const {
+    uint64_t sequence = seed ^ (index * 0xD1B54A32D192ED03ULL);
+    return Rng::splitmix64(sequence);
 }
 
-void Game::initializeFruits() {
-    fruits.clear();
-    fruits.emplace_back(FruitType::APPLE, "🍎", 10, "Apple");
-    fruits.emplace_back(FruitType::BANANA, "🍌", 15, "Banana");
-    fruits.emplace_back(FruitType::ORANGE, "🍊", 12, "Orange");
-    fruits.emplace_back(FruitType::GRAPE, "🍇", 8, "Grape");
-    fruits.emplace_back(FruitType::WATERMELON, "🍉", 20, "Watermelon");
-    fruits.emplace_back(FruitType::STRAWBERRY, "🍓", 18, "Strawberry");
-    fruits.emplace_back(FruitType::SPECIAL, "🌟", 30, "Star");
+// Restarts every random stream from the given game seed
+void Game::seedGame(uint64_t newGameSeed) {
+    gameSeed = newGameSeed;
+    Rng root(gameSeed);
+    spawnRng = root.split();
+    effectRng = root.split();
+    cosmeticRng = root.split();
 }
 
 void Game::initializeBaskets() {
     baskets.clear();
     int basketWidth = 3; // Initial width for all baskets
-    int spacing = SCREEN_WIDTH / fruits.size();
-    for (size_t i = 0; i < fruits.size(); ++i) {
-        baskets.emplace_back(i * spacing + spacing / 2, basketWidth, static_cast<FruitType>(i), fruits[i].symbol);
+    int spacing = screenWidth / FRUIT_KINDS;
+    for (int i = 0; i < FRUIT_KINDS; ++i) {
+        baskets.emplace_back(i * spacing + spacing / 2, basketWidth, FRUIT_ARCHETYPES[i].type);
+    }
+    basketIndex.stale = true;
+}
+
+// Brings basketIndex up to date with the baskets
+const BasketIndex& Game::currentBasketIndex() {
+    if (basketIndex.stale) basketIndex.rebuild(baskets, screenWidth, FRUIT_KINDS);
+    return basketIndex;
+}
+
+// Listens for resizes and phase report requests and reads the terminal size,
+// without touching the playfield size
+void Game::attachTerminal() {
+    openSignalWakePipe();
+    installResizeHandler();
+    installPhaseReportHandler();
+    queryTerminalSize(terminalColumns, terminalRows);
+    phaseTimes.enabled = true;
+}
+
+// Sizes the playfield to the terminal. Baskets, the fruit and particles keep
+// their relative position, so a resize never restarts the game.
+void Game::updateLayout() {
+    int columns, rows;
+    int newWidth = SCREEN_WIDTH;
+    int newHeight = SCREEN_HEIGHT;
+    if (queryTerminalSize(columns, rows)) {
+        terminalColumns = columns;
+        terminalRows = rows;
+        newWidth = std::clamp(columns - 2, MIN_SCREEN_WIDTH, MAX_SCREEN_WIDTH); // Side borders
+        newHeight = std::clamp(rows - 1 - HUD_STATUS_ROWS, MIN_SCREEN_HEIGHT, MAX_SCREEN_HEIGHT); // Frame is one row taller than the board, plus the status lines
+    }
+    resizePlayfield(newWidth, newHeight);
+}
+
+void Game::resizePlayfield(int newWidth, int newHeight) {
+    if (newWidth == screenWidth && newHeight == screenHeight) return;
+
+    for (auto& basket : baskets) {
+        basket.x = std::clamp(basket.x * newWidth / screenWidth, basket.width / 2, newWidth - 1 - basket.width / 2);
+    }
+    fallingFruits.forEach([&](int slot) {
+        fallingFruits.x[slot] = static_cast<int16_t>(std::clamp(fallingFruits.x[slot] * newWidth / screenWidth, 0, newWidth - 1));
+        fallingFruits.y[slot] = fallingFruits.previousY[slot] = fallingFruits.y[slot] * newHeight / screenHeight;
+    });
+    for (int i = 0; i < particles.size(); ++i) {
+        particles.x[i] = static_cast<int16_t>(particles.x[i] * newWidth / screenWidth);
+        particles.y[i] = static_cast<int16_t>(particles.y[i] * newHeight / screenHeight);
     }
+    screenWidth = newWidth;
+    screenHeight = newHeight;
+    basketIndex.stale = true;
 }
 
 void Game::initializeAchievements() {
@@ -551,12 +2492,23 @@ void Game::initializeAnimations() {
 
 void Game::initializeEffects() {
     activeEffects.clear();
-    activeEffects.emplace_back(GameEffectType::SPEED_BOOST, 0, "💨");
-    activeEffects.emplace_back(GameEffectType::SHIELD, 0, "🛡️");
-    activeEffects.emplace_back(GameEffectType::DOUBLE_SCORE, 0, "2️⃣X");
-    activeEffects.emplace_back(GameEffectType::MAGNET, 0, "🧲");
-    activeEffects.emplace_back(GameEffectType::INVISIBILITY, 0, "👻");
-    activeEffects.emplace_back(GameEffectType::COLOR_SHIFT, 0, "🎨");
+    for (int i = 0; i < EFFECT_COUNT; ++i) {
+        GameEffectType type = static_cast<GameEffectType>(i);
+        activeEffects.emplace_back(type, 0);
+    }
+}
+
+// Decodes every symbol the game can draw once, up front, and freezes the
+// table so both threads only ever look glyphs up
+void Game::initializeGlyphs() {
+    glyphs.internText("║★");
+    glyphs.internText(playerName);
+    for (int i = 0; i < FRUIT_KINDS; ++i) fruitGlyphs[i] = glyphs.intern(FRUIT_ARCHETYPES[i].glyph);
+    for (const auto& effect : EFFECT_ARCHETYPES) glyphs.internText(effect.glyph);
+    for (const auto& powerup : POWERUP_ARCHETYPES) glyphs.internText(powerup.glyph);
+    for (const auto& animation : animations) glyphs.internText(animation);
+    glyphs.internText("🏆⭐🎯💔🎁");     // Game message markers
+    glyphs.freeze();
 }
 
 void Game::loadHighScores() {
@@ -585,306 +2537,649 @@ void Game::saveHighScore(int score) {
 }
 
 void Game::drawGameBorder() {
-    std::cout << colorCode(4); // Blue color for the border
-    std::cout << "+";
-    for (int i = 0; i < SCREEN_WIDTH; ++i) std::cout << "-";
-    std::cout << "+" << "\n";
-    std::cout << colorCode(7); // Reset color
+    output.append(colorCode(4)); // Blue color for the border
+    output.append('+');
+    output.appendRepeat('-', screenWidth);
+    output.append("+\n");
+    output.append(colorCode(7)); // Reset color
 }
 
-void Game::drawCombo() {
-    if (combo > 0) {
-        std::string comboText = "Combo: " + std::to_string(combo);
-        if (comboMultiplier > 1) {
-            comboText += " (x" + std::to_string(comboMultiplier) + ")";
+// Copies the drawable state into the free snapshot slot and publishes it to
+// the render thread. Runs on the simulation thread.
+void Game::publishSnapshot() {
+    RenderSnapshot& view = snapshots.writeSlot();
+    view.sequence = ++snapshotSequence;
+    view.screenWidth = screenWidth;
+    view.screenHeight = screenHeight;
+    view.terminalColumns = terminalColumns;
+    view.terminalRows = terminalRows;
+    view.playerName = playerName;
+    view.score = score;
+    view.lives = lives;
+    view.level = level;
+    view.difficultyLevel = difficultyLevel;
+    view.combo = combo;
+    view.comboMultiplier = comboMultiplier;
+    view.effectSeconds.fill(-1);
+    for (const auto& effect : activeEffects) {
+        if (effect.active) {
+            view.effectSeconds[static_cast<int>(effect.type)] =
+                static_cast<int16_t>(std::chrono::ceil<std::chrono::seconds>(effect.endTime - simTime).count());
         }
-        std::cout << colorCode(3) << comboText << colorCode(7) << "\n"; // Yellow color for combo
     }
+    view.powerupType = hasPowerup ? static_cast<int>(currentPowerup.type) : -1;
+    view.powerupSeconds = hasPowerup ? std::max(0, static_cast<int>(std::chrono::duration_cast<std::chrono::seconds>(
+                                           lastPowerupTime + std::chrono::seconds(currentPowerup.duration) - simTime).count()))
+                                     : 0;
+    view.paused = isPaused;
+    view.tickStart = tickStart;
+    view.tickPeriod = tickPeriod();
+    view.fruits.clear();
+    fallingFruits.forEach([&](int slot) {
+        double y = fallingFruits.y[slot];
+        const int kind = fallingFruits.kind[slot];
+        view.fruits.push_back({fallingFruits.x[slot], fruitGlyphs[kind], FRUIT_ARCHETYPES[kind].color, y,
+                               isPaused ? y : fallingFruits.previousY[slot]});
+    });
+    view.baskets.clear();
+    for (const auto& basket : baskets) {
+        view.baskets.push_back({static_cast<int16_t>(basket.x), static_cast<int16_t>(basket.width), fruitGlyphs[static_cast<int>(basket.type)]});
+    }
+    view.particles.clear();
+    for (int i = 0; i < particles.size(); ++i) {
+        view.particles.push_back({particles.x[i], particles.y[i], particles.glyph[i], particles.color[i]});
+    }
+    if (!snapshots.publish()) renderStats.droppedFrames++;
+    {
+        std::lock_guard<std::mutex> lock(snapshotMutex); // A render thread about to wait has either seen the snapshot or is waiting now
+    }
+    snapshotPublished.notify_one();
 }
 
-void Game::drawGame() {
-    clearScreen();
-    
+void Game::startRenderThread() {
+    if (renderThreadRunning.exchange(true)) return;
+    hud.invalidate();
+    renderThread = std::thread(&Game::renderLoop, this);
+}
+
+void Game::stopRenderThread() {
+    if (!renderThreadRunning.exchange(false)) return;
+    {
+        std::lock_guard<std::mutex> lock(snapshotMutex);
+    }
+    snapshotPublished.notify_one();
+    if (renderThread.joinable()) renderThread.join();
+}
+
+// Draws the newest snapshot at the target frame rate, so a slow terminal only
+// delays frames and never the simulation tick. While the terminal is still
+// draining earlier output the frame is skipped; the next one that goes out
+// carries every change made in between.
+void Game::renderLoop() {
+    const auto framePeriod = std::chrono::microseconds(1000000 / FRAME_RATES[frameRateIndex]);
+    auto nextFrame = std::chrono::steady_clock::now();
+    bool pending = false; // A consumed snapshot has not been presented yet
+    uint64_t lastPresented = 0;
+    while (renderThreadRunning.load(std::memory_order_acquire)) {
+        if (snapshots.consume()) pending = true;
+        if (!pending && (lastPresented == 0 || snapshots.readSlot().paused)) {
+            // Paused, or nothing to show yet: sleep until the simulation publishes again
+            std::unique_lock<std::mutex> lock(snapshotMutex);
+            snapshotPublished.wait(lock, [this] { return snapshots.fresh() || !renderThreadRunning.load(std::memory_order_acquire); });
+            nextFrame = std::chrono::steady_clock::now();
+            continue;
+        } else if (outputBacklogged(STDOUT_FILENO)) {
+            renderStats.skippedFrames++;
+        } else {
+            // Between ticks the last snapshot is drawn again with a later alpha,
+            // so motion stays smooth at any tick rate. Unchanged cells cost nothing.
+            const RenderSnapshot& view = snapshots.readSlot();
+            if (!pending) renderStats.duplicatedFrames++;
+            else if (view.sequence > lastPresented + 1) renderStats.coalescedFrames++;
+            lastPresented = view.sequence;
+            {
+                PhaseTimer timer(phaseTimes, PHASE_DRAW);
+                drawGame(view);
+            }
+            pending = false;
+        }
+        nextFrame += framePeriod;
+        auto now = std::chrono::steady_clock::now();
+        if (nextFrame < now) nextFrame = now; // Do not try to catch up after a stall
+        std::this_thread::sleep_until(nextFrame);
+    }
+    // Make sure the final state of the game is on screen
+    if (snapshots.consume() || pending) drawGame(snapshots.readSlot());
+}
+
+// Renders one snapshot. Runs on the render thread and only reads the snapshot
+// and the glyph table.
+void Game::drawGame(const RenderSnapshot& view) {
+    const uint8_t borderColor = 4;
+    const uint8_t textColor = 7;
+    const uint16_t wall = glyphs.find("║");
+    const int frameWidth = view.screenWidth + 2;
+    const int frameHeight = view.screenHeight + 1 + HUD_STATUS_ROWS;
+    if (screenLost.exchange(false, std::memory_order_relaxed)) {
+        frame.invalidate();
+        tooSmallNotice = {0, 0};
+    }
+    // A frame bigger than the terminal would wrap into a mess, so ask for more room instead
+    if (view.terminalColumns > 0 && (view.terminalColumns < frameWidth || view.terminalRows < frameHeight)) {
+        drawTerminalTooSmall(view, frameWidth, frameHeight);
+        return;
+    }
+    tooSmallNotice = {0, 0};
+    // Reallocate only when the terminal has actually changed size
+    if (frame.getWidth() != frameWidth || frame.getHeight() != frameHeight) frame.resize(frameWidth, frameHeight);
+    frame.clear();
+
     // 重新設計UI佈局
-    std::cout << colorCode(4) << "+" << std::string(SCREEN_WIDTH, '-') << "+\n" << colorCode(7);
-    
+    int row = 0;
+    frame.put(0, row, '+', borderColor);
+    for (int x = 1; x <= view.screenWidth; ++x) frame.put(x, row, '-', borderColor);
+    frame.put(view.screenWidth + 1, row, '+', borderColor);
+
     // 第一行：玩家資訊
-    std::string info = "Player: " + playerName + 
-                      " | Score: " + std::to_string(score) + 
-                      " | Lives: ";
-    std::cout << colorCode(4) << "║" << colorCode(7);
-    std::cout << std::left << info;
-    for(int i = 0; i < lives; i++) {
-        std::cout << "<3 ";
+    row++;
+    if (hud.playerInfo.needsUpdate({view.score, view.lives, view.screenWidth})) {
+        hud.refreshes++;
+        char info[128];
+        int infoLength = std::snprintf(info, sizeof(info), "Player: %s | Score: %d | Lives: ", view.playerName.c_str(), view.score);
+        hud.playerInfo.append(glyphs, std::string_view(info, std::min(infoLength, static_cast<int>(sizeof(info)) - 1)), textColor);
+        for (int i = 0; i < view.lives && hud.playerInfo.width() + 3 <= view.screenWidth; i++) {
+            hud.playerInfo.append(glyphs, "<3 ", textColor);
+        }
     }
-    std::cout << std::string(SCREEN_WIDTH - info.length() - lives*3, ' ') << colorCode(4) << "║\n";
+    frame.put(0, row, wall, borderColor);
+    frame.blit(1, row, hud.playerInfo.getCells(), view.screenWidth);
+    frame.put(view.screenWidth + 1, row, wall, borderColor);
 
     // 第二行：等級和難度
-    std::string levelInfo = "Level: " + std::to_string(level) + 
-                           " | Difficulty: " + DIFFICULTY_LEVELS[difficultyLevel];
-    std::cout << "║" << colorCode(7);
-    std::cout << std::left << levelInfo;
-    std::cout << std::string(SCREEN_WIDTH - levelInfo.length(), ' ') << colorCode(4) << "║\n";
+    row++;
+    if (hud.levelInfo.needsUpdate({view.level, view.difficultyLevel})) {
+        hud.refreshes++;
+        char levelInfo[96];
+        int levelInfoLength = std::snprintf(levelInfo, sizeof(levelInfo), "Level: %d | Difficulty: %s",
+                                            view.level, DIFFICULTY_LEVELS[view.difficultyLevel].c_str());
+        hud.levelInfo.append(glyphs, std::string_view(levelInfo, std::min(levelInfoLength, static_cast<int>(sizeof(levelInfo)) - 1)), textColor);
+    }
+    frame.put(0, row, wall, borderColor);
+    frame.blit(1, row, hud.levelInfo.getCells(), view.screenWidth);
+    frame.put(view.screenWidth + 1, row, wall, borderColor);
 
     // 遊戲區域邊框
-    std::cout << "║" << std::string(SCREEN_WIDTH, ' ') << "║\n";
-    
+    row++;
+    frame.put(0, row, wall, borderColor);
+    frame.put(view.screenWidth + 1, row, wall, borderColor);
+
     // 繪製遊戲內容
-    for (int y = 0; y < SCREEN_HEIGHT - 6; y++) {
-        std::cout << colorCode(4) << "║" << colorCode(7);
-        for (int x = 0; x < SCREEN_WIDTH; x++) {
-            bool drawn = false;
-            
+    // The snapshot is up to one tick old by the time it is drawn, so fruits
+    // are placed between their last two positions by how far into the tick we are
+    double alpha = std::chrono::duration<double>(std::chrono::steady_clock::now() - view.tickStart) / view.tickPeriod;
+    rasterizePlayfield(view, std::clamp(alpha, 0.0, 1.0));
+    const int basketRow = view.screenHeight - 7;
+    for (int y = 0; y < view.screenHeight - 6; y++) {
+        row++;
+        frame.put(0, row, wall, borderColor);
+        const int32_t* particleRow = raster.particleAt.data() + static_cast<size_t>(y) * view.screenWidth;
+        const int16_t* fruitRow = raster.fruitAt.data() + static_cast<size_t>(y) * view.screenWidth;
+        // Glyphs are laid out by display column; a wide one covers the next cell too
+        for (int x = 0; x < view.screenWidth;) {
+            uint16_t glyph = ' ';
+            uint8_t color = textColor;
             // 繪製水果
-            if (currentFruit && y == fruitY && x == fruitX) {
-                std::cout << currentFruit->symbol;
-                drawn = true;
-            }
-            
+            if (fruitRow[x] >= 0) {
+                glyph = view.fruits[fruitRow[x]].glyph;
+                color = view.fruits[fruitRow[x]].color;
             // 繪製籃子
-            for (const auto& basket : baskets) {
-                if (y == SCREEN_HEIGHT - 7 && 
-                    x >= basket.x - basket.width/2 && 
-                    x <= basket.x + basket.width/2) {
-                    std::cout << basket.symbol;
-                    drawn = true;
-                    break;
-                }
-            }
-            
+            } else if (y == basketRow && raster.basketAt[x] >= 0) {
+                // A wide glyph that would run past the basket's catch zone is
+                // clipped, so a basket is never drawn wider than it catches
+                const int16_t basket = raster.basketAt[x];
+                const int last = x + glyphs.width(view.baskets[basket].glyph) - 1;
+                if (last < view.screenWidth && raster.basketAt[last] == basket) glyph = view.baskets[basket].glyph;
             // 繪製粒子效果
-            if (!drawn) {
-                bool particleDrawn = false;
-                for (const auto& particle : particles) {
-                    if (particle.x == x && particle.y == y) {
-                        std::cout << colorCode(particle.color) << particle.symbol << colorCode(7);
-                        particleDrawn = true;
-                        break;
-                    }
-                }
-                if (!particleDrawn) {
-                    std::cout << " ";
-                }
+            } else if (particleRow[x] >= 0) {
+                const auto& particle = view.particles[particleRow[x]];
+                glyph = particle.glyph;
+                color = particle.color;
             }
+            if (x + glyphs.width(glyph) > view.screenWidth) glyph = ' '; // Keep wide glyphs off the border
+            x += glyph == ' ' ? 1 : frame.put(x + 1, row, glyph, color);
+        }
+        frame.put(view.screenWidth + 1, row, wall, borderColor);
+    }
+
+    // 底部邊框
+    row++;
+    frame.put(0, row, '+', borderColor);
+    for (int x = 1; x <= view.screenWidth; ++x) frame.put(x, row, '-', borderColor);
+    frame.put(view.screenWidth + 1, row, '+', borderColor);
+
+    // 控制提示
+    std::string_view controls = view.paused ? "Game Paused. Press any key to continue..." : "[A/D] Move [P] Pause [Q] Quit";
+    row += 2;
+    frame.putText((view.screenWidth - displayWidth(controls)) / 2, row, controls, textColor);
+
+    // 狀態列
+    drawCombo(view, ++row);
+    drawProgressBar(view, ++row);
+    drawEffects(view, ++row);
+    drawPowerupStatus(view, ++row);
+
+    // Only the cells that changed since the last frame are written out
+    const size_t start = output.size();
+    if (synchronizedOutput) output.append(BEGIN_SYNCHRONIZED_UPDATE);
+    size_t bytes = frame.present(output);
+    if (bytes == 0) {
+        output.truncate(start); // Nothing changed, so nothing to write
+        presentOutput();
+        return;
+    }
+    if (synchronizedOutput) output.append(END_SYNCHRONIZED_UPDATE);
+    int writeCalls = presentOutput();
+
+    renderStats.framesPresented++;
+    renderStats.totalBytes += bytes;
+    renderStats.lastFrameBytes = bytes;
+    renderStats.peakFrameBytes = std::max(renderStats.peakFrameBytes, bytes);
+    renderStats.totalWriteCalls += writeCalls;
+    renderStats.lastFrameWriteCalls = writeCalls;
+    renderStats.hudRefreshes = hud.refreshes;
+}
+
+// Shows, in place of the game, that a columns x rows frame does not fit the
+// terminal. Drawn once per terminal size; the frame is invalidated so the game
+// comes back on a cleared screen once the terminal is large enough.
+void Game::drawTerminalTooSmall(const RenderSnapshot& view, int columns, int rows) {
+    if (tooSmallNotice == std::make_pair(view.terminalColumns, view.terminalRows)) return;
+    tooSmallNotice = {view.terminalColumns, view.terminalRows};
+    frame.invalidate();
+    clearScreen();
+    // The sizes are what the notice is for: they switch to a terse form when the
+    // sentence does not fit, and take the only row when there is just one
+    char size[64];
+    int length = std::snprintf(size, sizeof(size), "Need %dx%d, have %dx%d", columns, rows, view.terminalColumns, view.terminalRows);
+    if (length > view.terminalColumns) {
+        std::snprintf(size, sizeof(size), "%dx%d>%dx%d", columns, rows, view.terminalColumns, view.terminalRows);
+    }
+    const std::string_view lines[] = {"Terminal too small", size};
+    const int first = view.terminalRows < 2 ? 1 : 0;
+    for (int i = first; i < 2; ++i) {
+        output.appendf("\033[%d;1H", i - first + 1);
+        output.append(lines[i].substr(0, view.terminalColumns));
+    }
+    presentOutput();
+}
+
+// Stamps baskets and particles into the raster so drawGame's cell loop
+// costs the same no matter how many of either there are.
+void Game::rasterizePlayfield(const RenderSnapshot& view, double alpha) {
+    const int rows = view.screenHeight - 6;
+    raster.basketAt.assign(view.screenWidth, -1);
+    for (size_t i = 0; i < view.baskets.size(); ++i) {
+        const auto& basket = view.baskets[i];
+        int left = std::max(0, basket.x - basket.width / 2);
+        int right = std::min(view.screenWidth - 1, basket.x + basket.width / 2);
+        for (int x = left; x <= right; ++x) {
+            if (raster.basketAt[x] < 0) raster.basketAt[x] = static_cast<int16_t>(i); // Earlier baskets win overlaps
         }
-        std::cout << colorCode(4) << "║" << colorCode(7) << "\n";
     }
 
-    // 底部邊框
-    std::cout << colorCode(4) << "+" << std::string(SCREEN_WIDTH, '-') << "+\n" << colorCode(7);
+    raster.particleAt.assign(static_cast<size_t>(view.screenWidth) * rows, -1);
+    for (size_t i = 0; i < view.particles.size(); ++i) {
+        const auto& particle = view.particles[i];
+        if (particle.x < 0 || particle.x >= view.screenWidth || particle.y < 0 || particle.y >= rows) continue;
+        int32_t& cell = raster.particleAt[static_cast<size_t>(particle.y) * view.screenWidth + particle.x];
+        if (cell < 0) cell = static_cast<int32_t>(i); // Earlier particles win overlaps
+    }
 
-    // 控制提示
-    std::string controls = "[A/D] Move [P] Pause [Q] Quit";
-    printCenteredText(controls, 1);
+    raster.fruitAt.assign(static_cast<size_t>(view.screenWidth) * rows, -1);
+    for (size_t i = 0; i < view.fruits.size(); ++i) {
+        const auto& fruit = view.fruits[i];
+        int y = static_cast<int>(fruit.previousY + (fruit.y - fruit.previousY) * alpha);
+        if (fruit.x < 0 || fruit.x >= view.screenWidth || y < 0 || y >= rows) continue;
+        int16_t& cell = raster.fruitAt[static_cast<size_t>(y) * view.screenWidth + fruit.x];
+        if (cell < 0) cell = static_cast<int16_t>(i);
+    }
+}
+
+// Blanks the terminal; takes effect with the next presentOutput()
+void Game::clearScreen() {
+    output.append(SGR_RESET);
+    output.append("\033[H\033[2J");
+}
+
+// Writes the composed screen to the terminal and returns the write(2) calls it took
+int Game::presentOutput() {
+    return output.flush(STDOUT_FILENO);
 }
 
 void Game::drawMenu() {
     clearScreen();
-    printCenteredText("Fruity-Frenzy-Basket-Bonanza", SCREEN_HEIGHT / 2 - 10);
-    printCenteredText("1. Start Game", SCREEN_HEIGHT / 2 - 4);
-    printCenteredText("2. Shop", SCREEN_HEIGHT / 2 - 2);
-    printCenteredText("3. Instructions", SCREEN_HEIGHT / 2);
-    printCenteredText("4. High Scores", SCREEN_HEIGHT / 2 + 2);
-    printCenteredText("5. Settings", SCREEN_HEIGHT / 2 + 4);
-    printCenteredText("6. Exit Game", SCREEN_HEIGHT / 2 + 6);
-    std::cout << "\nSelect option: ";
+    // 17 rows from title to prompt, centred; the smallest playable terminal fits them exactly
+    const int top = std::max(0, menuRows() / 2 - 8);
+    printCenteredText("Fruity-Frenzy-Basket-Bonanza", top);
+    printCenteredText("1. Start Game", top + 4);
+    printCenteredText("2. Shop", top + 6);
+    printCenteredText("3. Instructions", top + 8);
+    printCenteredText("4. High Scores", top + 10);
+    printCenteredText("5. Settings", top + 12);
+    printCenteredText("6. Exit Game", top + 14);
+    printCenteredText("Select option: ", top + 16);
+    presentOutput();
 }
 
 void Game::displayShop() {
     clearScreen();
-    printCenteredText("Welcome to the Shop!", 5);
-    printCenteredText("Your Coins: " + std::to_string(coins), 7);
+    printCenteredText("Welcome to the Shop!", 1);
+    printCenteredText("Your Coins: " + std::to_string(coins), 3);
 
-    // Display the shop items with increased spacing and borders
-    for (size_t i = 0; i < shopItems.size(); ++i) {
-        std::cout << std::setw(5) << "" << "╔═════════════════════════════════════╗" << std::endl;
-        std::cout << std::setw(5) << "" << "║ Item " << i + 1 << ": " << std::left << std::setw(25) << shopItems[i].name << "║" << std::endl;
-        std::cout << std::setw(5) << "" << "║ Description: " << std::left << std::setw(18) << shopItems[i].description << "║" << std::endl;
-        std::cout << std::setw(5) << "" << "║ Price: " << std::left << std::setw(22) << shopItems[i].price << "║" << std::endl;
-        std::cout << std::setw(5) << "" << "║ Status: " << (shopItems[i].unlocked ? "Unlocked" : "Locked") << std::setw(15) << " " << "║" << std::endl;
-        std::cout << std::setw(5) << "" << "╚═════════════════════════════════════╝" << std::endl;
-        std::cout << std::endl;
+    // Display the shop items with increased spacing and borders, as many as fit above the prompt
+    const int promptRow = menuRows() - 3;
+    int row = 5;
+    char line[160];
+    for (size_t i = 0; i < shopItems.size() && row + 5 <= promptRow; ++i, row += 6) {
+        const ShopItem& item = shopItems[i];
+        printText("╔═════════════════════════════════════╗", 5, row);
+        std::snprintf(line, sizeof(line), "║ Item %zu: %-25s║", i + 1, item.name.c_str());
+        printText(line, 5, row + 1);
+        std::snprintf(line, sizeof(line), "║ Description: %-18s║", item.description.c_str());
+        printText(line, 5, row + 2);
+        std::snprintf(line, sizeof(line), "║ Price: %-22d║", item.price);
+        printText(line, 5, row + 3);
+        std::snprintf(line, sizeof(line), "║ Status: %s%15s║", item.unlocked ? "Unlocked" : "Locked", " ");
+        printText(line, 5, row + 4);
+        printText("╚═════════════════════════════════════╝", 5, row + 5);
     }
 
-    printCenteredText("Enter item number to buy, or 0 to return to menu:", SCREEN_HEIGHT - 3);
+    printCenteredText("Press an item number to buy, or any other key to return to menu:", promptRow);
+    presentOutput();
+}
 
-    // Shop logic
-    int choice;
-    std::cin >> choice;
+void Game::buyShopItem(char key) {
+    int choice = std::isdigit(static_cast<unsigned char>(key)) ? key - '0' : 0;
     if (choice > 0 && choice <= shopItems.size()) {
         ShopItem& item = shopItems[choice - 1];
         if (!item.unlocked && coins >= item.price) {
             coins -= item.price;
             item.unlocked = true;
             // Implement item-specific logic here (e.g., unlocking new baskets)
-            printCenteredText("You have purchased " + item.name + "!", SCREEN_HEIGHT - 1);
+            printCenteredText("You have purchased " + item.name + "!", menuRows() - 1);
         } else if (item.unlocked) {
-            printCenteredText("Item already unlocked!", SCREEN_HEIGHT - 1);
+            printCenteredText("Item already unlocked!", menuRows() - 1);
         } else {
-            printCenteredText("Not enough coins!", SCREEN_HEIGHT - 1);
+            printCenteredText("Not enough coins!", menuRows() - 1);
         }
+        presentOutput();
         std::this_thread::sleep_for(std::chrono::seconds(2));
     }
 }
 
 void Game::drawInstructions() {
     clearScreen();
-    printCenteredText("Instructions", 5);
-    printCenteredText("Use A/D keys to move baskets", 7);
-    printCenteredText("Catch falling fruits with the correct basket", 9);
-    printCenteredText("Special fruits (🌟) give extra points", 11);
-    printCenteredText("Avoid missing fruits to keep lives", 13);
-    printCenteredText("Press P to pause the game", 15);
-    printCenteredText("Press Q to quit the game", 17);
-    printCenteredText("Earn points to level up and unlock new features", 19);
-    printCenteredText("Collect power-ups to gain special abilities", 21);
-    printCenteredText("Complete challenges to earn bonus rewards", 23);
-    printCenteredText("Visit the shop to unlock new items and customize your game", 25);
-    printCenteredText("Press any key to return to the main menu", SCREEN_HEIGHT - 3);
-    getch();
+    static constexpr std::string_view LINES[] = {
+        "Use A/D or the arrow keys to move baskets",
+        "Catch falling fruits with the correct basket",
+        "Special fruits (🌟) give extra points",
+        "Avoid missing fruits to keep lives",
+        "Press P to pause the game",
+        "Press Q to quit the game",
+        "Earn points to level up and unlock new features",
+        "Collect power-ups to gain special abilities",
+        "Complete challenges to earn bonus rewards",
+        "Visit the shop to unlock new items and customize your game",
+    };
+    const int promptRow = menuRows() - 2;
+    // Double-spaced when that still clears the prompt
+    const int spacing = 3 + 2 * static_cast<int>(std::size(LINES)) < promptRow ? 2 : 1;
+    printCenteredText("Instructions", 1);
+    int row = 3;
+    for (std::string_view line : LINES) {
+        if (row >= promptRow) break;
+        printCenteredText(line, row);
+        row += spacing;
+    }
+    printCenteredText("Press any key to return to the main menu", promptRow);
+    presentOutput();
 }
 
 void Game::drawHighScores() {
     clearScreen();
-    printCenteredText("High Scores", 5);
-    for (size_t i = 0; i < highScores.size(); ++i) {
-        std::cout << std::setw(3) << i + 1 << ". " << highScores[i] << "\n";
+    printCenteredText("High Scores", 1);
+    const int promptRow = menuRows() - 2;
+    char line[32];
+    for (size_t i = 0; i < highScores.size() && 3 + static_cast<int>(i) < promptRow; ++i) {
+        std::snprintf(line, sizeof(line), "%3zu. %d", i + 1, highScores[i]);
+        printText(line, 0, 3 + static_cast<int>(i));
     }
-    printCenteredText("Press any key to return to the main menu", SCREEN_HEIGHT - 3);
-    getch();
+    printCenteredText("Press any key to return to the main menu", promptRow);
+    presentOutput();
 }
 
 void Game::drawGameOver() {
-    stats.endTime = std::chrono::system_clock::now();
+    stats.endTime = simTime;
     clearScreen();
-    printCenteredText(colorCode(1) + "Game Over!" + colorCode(7), SCREEN_HEIGHT / 2 - 6);
-    printCenteredText("Final Score: " + std::to_string(score), SCREEN_HEIGHT / 2 - 4);
-    printCenteredText("Level Reached: " + std::to_string(level), SCREEN_HEIGHT / 2 - 2);
-    printCenteredText("Highest Combo: " + std::to_string(maxCombo), SCREEN_HEIGHT / 2);
-    printCenteredText("Fruits Caught: " + std::to_string(stats.totalFruitsCaught), SCREEN_HEIGHT / 2 + 2);
-    printCenteredText("Special Fruits: " + std::to_string(stats.totalSpecialFruitsCaught), SCREEN_HEIGHT / 2 + 4);
-    printCenteredText("Fruits Missed: " + std::to_string(stats.totalFruitsMissed), SCREEN_HEIGHT / 2 + 6);
-    printCenteredText("Power-ups Collected: " + std::to_string(stats.totalPowerUpsCollected), SCREEN_HEIGHT / 2 + 8);
-    printCenteredText("Effects Activated: " + std::to_string(stats.totalEffectsActivated), SCREEN_HEIGHT / 2 + 10);
-
-    // Display unlocked achievements
-    printCenteredText(colorCode(3) + "Unlocked Achievements:" + colorCode(7), SCREEN_HEIGHT / 2 + 12);
-    for (const auto& achievement : achievements) {
-        if (achievement.unlocked) {
-            std::cout << "  ★ " << achievement.name << " - " << achievement.description << "\n";
+    // Line after line from the top; whatever does not fit above the prompt is left out
+    const int promptRow = menuRows() - 1;
+    int row = 1;
+    auto addLine = [&](std::string_view text, bool centred = true) {
+        if (row < promptRow) {
+            if (centred) printCenteredText(text, row);
+            else printText(text, 0, row);
         }
-    }
+        row++;
+    };
+    addLine(std::string(colorCode(1)) + "Game Over!" + std::string(colorCode(7)));
+    row++;
+    addLine("Final Score: " + std::to_string(score));
+    addLine("Level Reached: " + std::to_string(level));
+    addLine("Highest Combo: " + std::to_string(maxCombo));
+    addLine("Fruits Caught: " + std::to_string(stats.totalFruitsCaught));
+    addLine("Special Fruits: " + std::to_string(stats.totalSpecialFruitsCaught));
+    addLine("Fruits Missed: " + std::to_string(stats.totalFruitsMissed));
+    addLine("Power-ups Collected: " + std::to_string(stats.totalPowerUpsCollected));
+    addLine("Effects Activated: " + std::to_string(stats.totalEffectsActivated));
 
     // Calculate and display the duration of the game
     if (stats.endTime > stats.startTime) {
         auto duration = std::chrono::duration_cast<std::chrono::seconds>(stats.endTime - stats.startTime).count();
-        printCenteredText("Game Duration: " + std::to_string(duration) + " seconds", SCREEN_HEIGHT / 2 + 14);
+        addLine("Game Duration: " + std::to_string(duration) + " seconds");
+    }
+    addLine("Seed: " + std::to_string(seed));
+    if (!recordStatus.empty()) addLine(recordStatus);
+
+    // Display unlocked achievements
+    row++;
+    addLine(std::string(colorCode(3)) + "Unlocked Achievements:" + std::string(colorCode(7)));
+    for (const auto& achievement : achievements) {
+        if (achievement.unlocked) addLine("  ★ " + achievement.name + " - " + achievement.description, false);
+    }
+
+    if (renderStats.framesPresented > 0) {
+        row++;
+        addLine("Output: " + std::to_string(renderStats.totalBytes / renderStats.framesPresented) +
+                " bytes/frame avg, " + std::to_string(renderStats.peakFrameBytes) + " peak, " +
+                std::to_string(renderStats.totalWriteCalls / renderStats.framesPresented) + " write/frame");
+        addLine("Frames: " + std::to_string(renderStats.framesPresented) + " presented, " +
+                std::to_string(renderStats.skippedFrames) + " skipped, " +
+                std::to_string(renderStats.coalescedFrames) + " coalesced, " +
+                std::to_string(renderStats.droppedFrames) + " dropped, " +
+                std::to_string(renderStats.duplicatedFrames) + " duplicated, " +
+                std::to_string(renderStats.hudRefreshes) + " HUD refreshes");
+    }
+    if (phaseTimes.enabled && phaseTimes.phases[PHASE_UPDATE].count() > 0) {
+        row++;
+        std::istringstream report(formatPhaseReport(phaseTimes));
+        for (std::string line; std::getline(report, line);) addLine(line, false);
     }
 
-    std::cout << "\n";
+    printCenteredText("Press any key to return to the main menu...", promptRow);
 }
 
 void Game::drawGameStats() {
-    auto now = std::chrono::system_clock::now();
+    auto now = simTime;
     auto gameDuration = std::chrono::duration_cast<std::chrono::seconds>(now - stats.startTime).count();
     int scorePerMinute = (gameDuration > 0) ? static_cast<int>(round(60.0 * score / gameDuration)) : score;
 
-    std::cout << colorCode(4) << "╔═══════════════════ Game Stats ═══════════════════╗" << colorCode(7) << "\n";
-    std::cout << colorCode(4) << "║ " << colorCode(7) << "Game Time: " << std::setw(5) << gameDuration << " seconds" << std::setw(17) << colorCode(4) << " ║" << colorCode(7) << "\n";
-    std::cout << colorCode(4) << "║ " << colorCode(7) << "Score/Minute: " << std::setw(5) << scorePerMinute << std::setw(20) << colorCode(4) << " ║" << colorCode(7) << "\n";
-    std::cout << colorCode(4) << "║ " << colorCode(7) << "Level: " << std::setw(2) << level << std::setw(28) << colorCode(4) << " ║" << colorCode(7) << "\n";
-    std::cout << colorCode(4) << "╚═════════════════════════════════════════════════╝" << colorCode(7) << "\n";
+    const std::string blue(colorCode(4));
+    const std::string white(colorCode(7));
+    output.appendf("%s╔═══════════════════ Game Stats ═══════════════════╗%s\n", blue.c_str(), white.c_str());
+    output.appendf("%s║ %sGame Time: %5ld seconds%17s ║%s\n", blue.c_str(), white.c_str(), static_cast<long>(gameDuration), blue.c_str(), white.c_str());
+    output.appendf("%s║ %sScore/Minute: %5d%20s ║%s\n", blue.c_str(), white.c_str(), scorePerMinute, blue.c_str(), white.c_str());
+    output.appendf("%s║ %sLevel: %2d%28s ║%s\n", blue.c_str(), white.c_str(), level, blue.c_str(), white.c_str());
+    output.appendf("%s╚═════════════════════════════════════════════════╝%s\n", blue.c_str(), white.c_str());
 }
 
-void Game::drawProgressBar() {
-    int width = SCREEN_WIDTH / 2;
-    int progress = (score % 100) * width / 100;
-    std::cout << colorCode(5) << "["; // Magenta color for progress bar
-    for (int i = 0; i < width; ++i) {
-        if (i < progress) std::cout << "=";
-        else if (i == progress) std::cout << ">";
-        else std::cout << " ";
-    }
-    std::cout << "] " << score % 100 << "/100 to next level" << colorCode(7) << "\n";
-}
 
 void Game::drawGameMessages() {
     if (!gameMessages.empty()) {
-        std::cout << colorCode(3) << "Latest Messages:" << colorCode(7) << "\n"; // Yellow for messages
+        output.append(colorCode(3)); // Yellow for messages
+        output.append("Latest Messages:");
+        output.append(colorCode(7));
+        output.append('\n');
         for (size_t i = 0; i < std::min(gameMessages.size(), static_cast<size_t>(3)); ++i) {
-            std::cout << "  - " << gameMessages[i] << "\n";
+            output.appendf("  - %s\n", gameMessages[i].c_str());
         }
     }
 }
 
-void Game::drawEffects() {
-    std::cout << colorCode(3) << "Active Effects: " << colorCode(7); // Yellow for effects
-    bool hasEffects = false;
-    for (const auto& effect : activeEffects) {
-        if (effect.active) {
-            std::cout << effect.symbol << " (" << effect.duration << "s) ";
+// The HUD status lines below render one snapshot each on the render thread.
+// Each is re-formatted only when the values it shows change.
+void Game::drawCombo(const RenderSnapshot& view, int row) {
+    if (hud.combo.needsUpdate({view.combo, view.comboMultiplier})) {
+        hud.refreshes++;
+        if (view.combo > 0) {
+            char text[48];
+            int length = view.comboMultiplier > 1 ? std::snprintf(text, sizeof(text), "Combo: %d (x%d)", view.combo, view.comboMultiplier)
+                                                  : std::snprintf(text, sizeof(text), "Combo: %d", view.combo);
+            hud.combo.append(glyphs, std::string_view(text, std::min(length, static_cast<int>(sizeof(text)) - 1)), 3); // Yellow color for combo
+        }
+    }
+    frame.blit(1, row, hud.combo.getCells(), view.screenWidth);
+}
+
+void Game::drawProgressBar(const RenderSnapshot& view, int row) {
+    const int progressScore = view.score % 100;
+    if (hud.progress.needsUpdate({progressScore, view.screenWidth})) {
+        hud.refreshes++;
+        int width = view.screenWidth / 2;
+        int progress = progressScore * width / 100;
+        std::string bar(width + 2, ' ');
+        bar.front() = '[';
+        bar.back() = ']';
+        for (int i = 0; i < width; ++i) {
+            if (i < progress) bar[i + 1] = '=';
+            else if (i == progress) bar[i + 1] = '>';
+        }
+        char suffix[32];
+        int length = std::snprintf(suffix, sizeof(suffix), " %d/100 to next level", progressScore);
+        hud.progress.append(glyphs, bar, 5); // Magenta color for progress bar
+        hud.progress.append(glyphs, std::string_view(suffix, std::min(length, static_cast<int>(sizeof(suffix)) - 1)), 5);
+    }
+    frame.blit(1, row, hud.progress.getCells(), view.screenWidth);
+}
+
+void Game::drawEffects(const RenderSnapshot& view, int row) {
+    const auto& seconds = view.effectSeconds;
+    if (hud.effects.needsUpdate({seconds[0], seconds[1], seconds[2], seconds[3], seconds[4], seconds[5]})) {
+        hud.refreshes++;
+        hud.effects.append(glyphs, "Active Effects: ", 3); // Yellow for effects
+        bool hasEffects = false;
+        for (int i = 0; i < EFFECT_COUNT; ++i) {
+            if (seconds[i] < 0) continue;
+            char duration[24];
+            int length = std::snprintf(duration, sizeof(duration), " (%ds) ", seconds[i]);
+            const auto& effect = EFFECT_ARCHETYPES[i];
+            hud.effects.append(glyphs, effect.glyph, effect.color);
+            hud.effects.append(glyphs, std::string_view(duration, std::min(length, static_cast<int>(sizeof(duration)) - 1)), effect.color);
             hasEffects = true;
         }
+        if (!hasEffects) hud.effects.append(glyphs, "None", 7);
     }
-    if (!hasEffects) std::cout << "None";
-    std::cout << "\n";
+    frame.blit(1, row, hud.effects.getCells(), view.screenWidth);
 }
 
-void Game::drawPowerupStatus() {
-    if (hasPowerup) {
-        std::cout << colorCode(6) << currentPowerup.description << " (" 
-                  << std::max(0, static_cast<int>(std::chrono::duration_cast<std::chrono::seconds>(lastPowerupTime + std::chrono::seconds(currentPowerup.duration) - std::chrono::system_clock::now()).count()))
-                  << "s)" << colorCode(7) << "\n";
+void Game::drawPowerupStatus(const RenderSnapshot& view, int row) {
+    if (hud.powerup.needsUpdate({view.powerupType, view.powerupSeconds})) {
+        hud.refreshes++;
+        if (view.powerupType >= 0) {
+            const auto& powerup = POWERUP_ARCHETYPES[view.powerupType];
+            char remaining[24];
+            int length = std::snprintf(remaining, sizeof(remaining), " (%ds)", view.powerupSeconds);
+            hud.powerup.append(glyphs, "Power-up: ", powerup.color);
+            hud.powerup.append(glyphs, powerup.glyph, powerup.color);
+            hud.powerup.append(glyphs, " ", powerup.color);
+            hud.powerup.append(glyphs, powerup.name, powerup.color);
+            hud.powerup.append(glyphs, std::string_view(remaining, std::min(length, static_cast<int>(sizeof(remaining)) - 1)), powerup.color);
+        }
     }
+    frame.blit(1, row, hud.powerup.getCells(), view.screenWidth);
+}
+
+// Draws text from column x of screen row y, both counted from 0. Rows below
+// the terminal are left out, so a long screen loses its end instead of
+// scrolling its top away.
+void Game::printText(std::string_view text, int x, int y) {
+    if (y < 0 || y >= menuRows()) return;
+    output.appendf("\033[%d;%dH", y + 1, std::max(0, x) + 1);
+    output.append(text);
 }
 
-void Game::printCenteredText(const std::string& text, int y) {
-    int padding = (SCREEN_WIDTH - static_cast<int>(text.length())) / 2;
-    for(int i = 0; i < y; i++)
-        std::cout << std::endl;
-    std::cout << std::setw(padding + text.length()) << text << "\n";
+void Game::printCenteredText(std::string_view text, int y) {
+    printText(text, (menuColumns() - displayWidth(text)) / 2, y);
 }
 
 void Game::drawScoreBoard() {
-    std::cout << colorCode(5) << "Recent Scores:" << colorCode(7) << "\n"; // Magenta for recent scores
+    output.append(colorCode(5)); // Magenta for recent scores
+    output.append("Recent Scores:");
+    output.append(colorCode(7));
+    output.append('\n');
     for (const auto& score : recentScores) {
-        std::cout << "  " << score.second << " - " << score.first << " points\n";
+        output.appendf("  %s - %d points\n", score.second.c_str(), score.first);
     }
 }
 
+// How many fruits may fall at once: one more every few levels
+int Game::fruitLimit() const {
+    return std::min(FruitPool::CAPACITY, 1 + (level - 1) / LEVELS_PER_EXTRA_FRUIT);
+}
+
 void Game::spawnFruit() {
-    if (!currentFruit) {
-        std::uniform_int_distribution<> distrib(0, fruits.size() - 1);
-        int fruitIndex = distrib(randomEngine);
-        currentFruit = new Fruit(fruits[fruitIndex]);
-        currentFruit->velocity_y = 1.0 + (level - 1) * 0.1; // Increase velocity with level
-
-        // Adjust special fruit spawn rate
-        if (specialFruitSpawnTimer > 0) {
-            specialFruitSpawnTimer--;
-            if (currentFruit->type == FruitType::SPECIAL) {
-                std::uniform_int_distribution<> specialDistrib(0, fruits.size() - 2); // excluding special fruit from re-roll
-                fruitIndex = specialDistrib(randomEngine);
-                delete currentFruit;
-                currentFruit = new Fruit(fruits[fruitIndex]);
-            }
-        }
-        if (currentFruit->type == FruitType::SPECIAL) {
-            specialFruitSpawnTimer = 10; // Reset timer after spawning a special fruit
+    int fallingCount = fallingFruits.size();
+    if (fallingCount >= fruitLimit()) return;
+    // Let the newest fruit get clear of the top before the next one follows it
+    bool topClear = true;
+    fallingFruits.forEach([&](int slot) { topClear = topClear && fallingFruits.y[slot] >= MIN_FRUIT_SPACING; });
+    if (!topClear) return;
+
+    int fruitIndex = spawnRng.range(0, FRUIT_KINDS - 1);
+
+    // Adjust special fruit spawn rate
+    if (specialFruitSpawnTimer > 0) {
+        specialFruitSpawnTimer--;
+        if (FRUIT_ARCHETYPES[fruitIndex].type == FruitType::SPECIAL) {
+            fruitIndex = spawnRng.range(0, FRUIT_KINDS - 2); // excluding special fruit from re-roll
         }
-        fruitY = 0;
-        fruitX = distrib(randomEngine) % (SCREEN_WIDTH - 10) + 5;
-        totalFruits++;
     }
+    if (FRUIT_ARCHETYPES[fruitIndex].type == FruitType::SPECIAL) {
+        specialFruitSpawnTimer = 10; // Reset timer after spawning a special fruit
+    }
+    int column = spawnRng.range(5, screenWidth - 6); // Anywhere at least 5 columns from either wall
+    fallingFruits.spawn(fruitIndex, column, 1.0 + (level - 1) * 0.1); // Increase velocity with level
+    totalFruits++;
 }
 
 void Game::updateGameSpeed() {
-    // Adjust game speed based on difficulty, level, and a minimum speed
-    int baseSpeed = 250;
+    // Adjust game speed based on difficulty, level, and a maximum speed.
+    // The step is how many milliseconds the fruit takes to fall one row.
+    int baseStep = 250;
     int levelImpact = level * 5;
     int difficultyImpact = difficultyLevel * 25;
-    int minSpeed = 50;
-    gameSpeed = std::max(minSpeed, baseSpeed - levelImpact - difficultyImpact);
+    int minStep = 50;
+    gameSpeed = 1000.0 / std::max(minStep, baseStep - levelImpact - difficultyImpact);
+    if (hasPowerup && currentPowerup.type == PowerupType::SLOW_MOTION) gameSpeed = 1000.0 / 200; // Outlasts a level-up
 }
 
 void Game::checkAchievements() {
@@ -909,14 +3204,14 @@ void Game::checkAchievements() {
                 }
                 if (allUnlocked) achievement.unlocked = true;
             } else if (achievement.name == "Fruit Collector") {
-                for (size_t i = 0; i < fruits.size() - 1; ++i){
+                for (int i = 0; i < FRUIT_KINDS - 1; ++i){
                     fruitsCollected[static_cast<FruitType>(i)] = false;
                 }
                 for (const auto& pair : fruitsCaughtByType) {
                     fruitsCollected[pair.first] = true;
                 }
                 bool allCollected = true;
-                for (size_t i = 0; i < fruits.size() - 1; ++i){
+                for (int i = 0; i < FRUIT_KINDS - 1; ++i){
                     if (!fruitsCollected[static_cast<FruitType>(i)]){
                         allCollected = false;
                         break;
@@ -933,210 +3228,209 @@ void Game::checkAchievements() {
     }
 }
 
-void Game::updateGameLogic() {
-    if (freezeTime) {
-        // Skip the fruit falling logic
-        return;
-    }
-    if (currentFruit) {
-        // Apply gravity effect
-        currentFruit->velocity_y += gravity;
-        fruitY += static_cast<int>(currentFruit->velocity_y);
-        // Check if the fruit has reached the bottom
-        if (fruitY >= SCREEN_HEIGHT - 1) {
-            bool caught = false;
-            for (const auto& basket : baskets) {
-                if (fruitX >= basket.x - basket.width / 2 && fruitX <= basket.x + basket.width / 2 && basket.type == currentFruit->type) {
-                    caught = true;
-                    int points = currentFruit->points;
-
-                    for (const auto& effect : activeEffects) {
-                        if (effect.active) {
-                            if (effect.type == GameEffectType::DOUBLE_SCORE) points *= 2;
-                            if (effect.type == GameEffectType::MAGNET) {
-                                if (abs(fruitX - basket.x) < 5) points *= 2; // Double points if fruit is close to the correct basket
-                            }
-                        }
-                    }
+// Scores a fruit that has reached the bottom as caught or missed and removes it
+void Game::landFruit(int slot) {
+    const FruitArchetype& fruit = FRUIT_ARCHETYPES[fallingFruits.kind[slot]];
+    const int fruitX = fallingFruits.x[slot];
+    const int row = static_cast<int>(fallingFruits.y[slot]);
+    const int catcher = currentBasketIndex().catcher(static_cast<int>(fruit.type), fruitX);
+    const bool caught = catcher >= 0;
+    if (caught) {
+        const Basket& basket = baskets[catcher];
+        int points = fruit.points;
 
-                    score += points * comboMultiplier;
-                    combo++;
-                    consecutiveCatches++;
+        for (const auto& effect : activeEffects) {
+            if (effect.active) {
+                if (effect.type == GameEffectType::DOUBLE_SCORE) points *= 2;
+                if (effect.type == GameEffectType::MAGNET) {
+                    if (abs(fruitX - basket.x) < 5) points *= 2; // Double points if fruit is close to the correct basket
+                }
+            }
+        }
 
-                    comboMultiplier = (consecutiveCatches >= 10) ? 3 : ((consecutiveCatches >= 5) ? 2 : 1);
-                    maxCombo = std::max(maxCombo, combo);
-                    stats.totalFruitsCaught++;
-                    if (currentFruit->type == FruitType::SPECIAL) stats.totalSpecialFruitsCaught++;
+        score += points * comboMultiplier;
+        combo++;
+        consecutiveCatches++;
 
-                    handleLevelProgression();
-                    lastScoreTime = std::chrono::system_clock::now();
+        comboMultiplier = (consecutiveCatches >= 10) ? 3 : ((consecutiveCatches >= 5) ? 2 : 1);
+        maxCombo = std::max(maxCombo, combo);
+        stats.totalFruitsCaught++;
+        if (fruit.type == FruitType::SPECIAL) stats.totalSpecialFruitsCaught++;
 
-                    // Generate particles when a fruit is caught
-                    addParticles(fruitX, fruitY, ParticleType::EXPLOSION, 5, 2); // Green particles for normal catch
-                    if (currentFruit->type == FruitType::SPECIAL) {
-                        addParticles(fruitX, fruitY, ParticleType::SPARKLE, 10, 3); // Yellow sparkles for special fruit
-                    }
+        handleLevelProgression();
+        lastScoreTime = simTime;
+
+        // Generate particles when a fruit is caught
+        addParticles(fruitX, row, ParticleType::EXPLOSION, 5, 2); // Green particles for normal catch
+        if (fruit.type == FruitType::SPECIAL) {
+            addParticles(fruitX, row, ParticleType::SPARKLE, 10, 3); // Yellow sparkles for special fruit
+        }
 
-                    // Update challenges progress
-                    for (auto& challenge : challenges) {
-                        if (challenge.active) {
-                            if (challenge.type == ChallengeType::SPEED_CHALLENGE) {
-                                challenge.progress++;
-                            } else if (challenge.type == ChallengeType::COMBO_CHALLENGE && combo > challenge.progress) {
-                                challenge.progress = combo;
-                            } else if (challenge.type == ChallengeType::ACCURACY_CHALLENGE) {
-                                challenge.progress++;
-                            } else if (challenge.type == ChallengeType::COLOR_CHALLENGE) {
-                                if (currentFruit->symbol == "@") { // Check for red fruit symbol (adjust as needed)
-                                    challenge.progress++;
-                                } else {
-                                    challenge.progress = 0; // Reset progress if not a red fruit
-                                }
-                            }
-                        }
+        // Update challenges progress
+        for (auto& challenge : challenges) {
+            if (challenge.active) {
+                if (challenge.type == ChallengeType::SPEED_CHALLENGE) {
+                    challenge.progress++;
+                } else if (challenge.type == ChallengeType::COMBO_CHALLENGE && combo > challenge.progress) {
+                    challenge.progress = combo;
+                } else if (challenge.type == ChallengeType::ACCURACY_CHALLENGE) {
+                    challenge.progress++;
+                } else if (challenge.type == ChallengeType::COLOR_CHALLENGE) {
+                    if (fruit.glyph == "@") { // Check for red fruit symbol (adjust as needed)
+                        challenge.progress++;
+                    } else {
+                        challenge.progress = 0; // Reset progress if not a red fruit
                     }
-                    fruitsCaughtByType[currentFruit->type]++; // Increment the count for the type of fruit caught
                 }
             }
-            if (!caught) {
-                lives--;
-                combo = 0;
-                consecutiveCatches = 0;
-                comboMultiplier = 1;
-                stats.totalFruitsMissed++;
-                addGameMessage("Missed! Lost a life");
-
-                // Update challenges progress
-                for (auto& challenge : challenges) {
-                    if (challenge.active && challenge.type == ChallengeType::ACCURACY_CHALLENGE) {
-                        challenge.target--; // Reduce target for accuracy challenge when a fruit is missed
-                    }
-                }
-                // Generate particles for a miss
-                addParticles(fruitX, fruitY, ParticleType::EXPLOSION, 5, 1); // Red particles for a miss
+        }
+        fruitsCaughtByType[fruit.type]++; // Increment the count for the type of fruit caught
+    }
+    if (!caught) {
+        lives--;
+        combo = 0;
+        consecutiveCatches = 0;
+        comboMultiplier = 1;
+        stats.totalFruitsMissed++;
+        addGameMessage("Missed! Lost a life");
+
+        // Update challenges progress
+        for (auto& challenge : challenges) {
+            if (challenge.active && challenge.type == ChallengeType::ACCURACY_CHALLENGE) {
+                challenge.target--; // Reduce target for accuracy challenge when a fruit is missed
             }
-            delete currentFruit;
-            currentFruit = nullptr;
-            checkAchievements();
         }
+        // Generate particles for a miss
+        addParticles(fruitX, row, ParticleType::EXPLOSION, 5, 1); // Red particles for a miss
+    }
+    fallingFruits.despawn(slot);
+    {
+        PhaseTimer timer(phaseTimes, PHASE_CHALLENGES);
+        updateChallenges(); // Progress only changes when a fruit lands
     }
+    PhaseTimer timer(phaseTimes, PHASE_ACHIEVEMENTS);
+    checkAchievements();
+}
 
-    // Trigger bonus mode and challenges at set intervals
-    auto now = std::chrono::system_clock::now();
-    if (std::chrono::duration_cast<std::chrono::seconds>(now - lastBonusTime).count() >= BONUS_INTERVAL) {
-        activateBonusMode();
-        lastBonusTime = now;
+// Advances the world by one fixed tick
+void Game::updateGameLogic() {
+    const auto dt = tickPeriod();
+    simTime += std::chrono::duration_cast<SimClock::duration>(dt);
+    gameTicks++;
+    // Freeze Time only stops the fruit; timers keep running so it can run out
+    const double fall = freezeTime ? 0.0 : gameSpeed * std::chrono::duration<double>(dt).count();
+    fallingFruits.forEach([&](int slot) {
+        fallingFruits.previousY[slot] = fallingFruits.y[slot];
+        // Each fruit falls at gameSpeed rows per second, times the whole rows per
+        // step it has always fallen: its velocity plus gravity, rounded down.
+        // Level 11 or a speed boost brings that to two.
+        fallingFruits.y[slot] += std::floor(fallingFruits.velocity[slot] + GRAVITY_ACCELERATION) * fall;
+        // Check if the fruit has reached the bottom
+        if (fallingFruits.y[slot] >= screenHeight - 1) landFruit(slot);
+    });
+
+    {
+        PhaseTimer timer(phaseTimes, PHASE_TIMERS);
+        timers.runDue(simTime);
     }
-    if (std::chrono::duration_cast<std::chrono::seconds>(now - lastChallengeTime).count() >= CHALLENGE_INTERVAL) {
-        triggerChallenge();
-        lastChallengeTime = now;
+
+    // The per-step rules keep the cadence the game is balanced for, whatever the tick rate
+    while (simTime >= nextRuleStep) {
+        updateRules();
+        nextRuleStep += RULE_STEP;
     }
+}
 
-    // Update bonus mode and challenges
-    updateBonusMode();
-    updateChallenges();
-    updateParticles();
+void Game::updateRules() {
+    {
+        PhaseTimer timer(phaseTimes, PHASE_PARTICLES);
+        updateParticles();
+    }
     updateFruitVelocity();
-    updateEffects();
-    applyPowerup();
+    {
+        PhaseTimer timer(phaseTimes, PHASE_POWERUP);
+        applyPowerup();
+    }
     activateRandomEffect();
     updateAnimation();
 }
 
 void Game::updateFruitVelocity() {
-    if (currentFruit) {
+    fallingFruits.forEach([&](int slot) {
+        const FruitType type = FRUIT_ARCHETYPES[fallingFruits.kind[slot]].type;
+        int16_t& fruitX = fallingFruits.x[slot];
         // Increase the velocity based on the level
-        currentFruit->velocity_y = 1.0 + (level - 1) * 0.05;
+        fallingFruits.velocity[slot] = 1.0 + (level - 1) * 0.05;
         // Apply active effects to the fruit
         for (const auto& effect : activeEffects) {
             if (effect.active) {
                 if (effect.type == GameEffectType::SPEED_BOOST) {
-                    currentFruit->velocity_y *= 1.5; // Increase velocity by 50%
+                    fallingFruits.velocity[slot] *= 1.5; // Increase velocity by 50%
                 } else if (effect.type == GameEffectType::MAGNET) {
                     // Find the nearest correct basket
-                    int minDistance = SCREEN_WIDTH;
-                    int targetX = fruitX;
-                    for (const auto& basket : baskets) {
-                        if (basket.type == currentFruit->type) {
-                            int distance = std::abs(basket.x - fruitX);
-                            if (distance < minDistance) {
-                                minDistance = distance;
-                                targetX = basket.x;
-                            }
-                        }
-                    }
+                    int target = currentBasketIndex().nearest(static_cast<int>(type), fruitX);
+                    int targetX = target >= 0 && std::abs(baskets[target].x - fruitX) < screenWidth ? baskets[target].x : fruitX;
                     // Move fruit towards the target basket
                     if (fruitX < targetX) {
-                        fruitX = std::min(fruitX + 1, targetX);
+                        fruitX = static_cast<int16_t>(std::min(fruitX + 1, targetX));
                     } else if (fruitX > targetX) {
-                        fruitX = std::max(fruitX - 1, targetX);
+                        fruitX = static_cast<int16_t>(std::max(fruitX - 1, targetX));
                     }
                 }
             }
         }
-    }
+    });
 }
 
+// Rolls for a power-up while none is held. Its effect starts at once and a
+// timer ends it.
 void Game::applyPowerup() {
-    if (hasPowerup) {
-        auto now = std::chrono::system_clock::now();
-        if (now >= lastPowerupTime + std::chrono::seconds(currentPowerup.duration)) {
-            hasPowerup = false;
-            if (currentPowerup.type == PowerupType::FREEZE_TIME) {
-                freezeTime = false; // Deactivate Freeze Time
-            }
-            addGameMessage(powerupTypeToString(currentPowerup.type) + " effect ended");
+    if (hasPowerup || !effectRng.chance(POWERUP_CHANCE)) return;
+
+    hasPowerup = true;
+    lastPowerupTime = simTime;
+    currentPowerup.type = static_cast<PowerupType>(effectRng.range(0, static_cast<int>(PowerupType::FREEZE_TIME)));
+    currentPowerup.duration = POWERUP_DURATION;
+
+    stats.totalPowerUpsCollected++;
+    // 更新powerup符號
+    addGameMessage("Power-up: " + std::string(powerupSymbol(currentPowerup.type)) + " " + powerupTypeToString(currentPowerup.type));
+
+    switch (currentPowerup.type) {
+        case PowerupType::DOUBLE_POINTS:
+            // Already handled in updateGameLogic()
+            break;
+        case PowerupType::SLOW_MOTION:
+            gameSpeed = 1000.0 / 200; // Slow down the game
+            break;
+        case PowerupType::EXTRA_LIFE:
+            lives++;
+            hasPowerup = false; // Consume the powerup immediately
             return;
-        }
+        case PowerupType::MAGNET:
+            // Handled in updateFruitVelocity()
+            break;
+        case PowerupType::SCORE_BOOST:
+            score += 50; // Add a flat score boost
+            hasPowerup = false; // Consume the powerup immediately
+            return;
+        case PowerupType::FREEZE_TIME:
+            freezeTime = true; // Activate Freeze Time
+            break;
+        default:
+            break;
+    }
+    timers.schedule(simTime + std::chrono::seconds(currentPowerup.duration), [this] { endPowerup(); });
+}
 
-        switch (currentPowerup.type) {
-            case PowerupType::DOUBLE_POINTS:
-                // Already handled in updateGameLogic()
-                break;
-            case PowerupType::SLOW_MOTION:
-                gameSpeed = 200; // Slow down the game
-                break;
-            case PowerupType::EXTRA_LIFE:
-                lives++;
-                hasPowerup = false; // Consume the powerup immediately
-                break;
-            case PowerupType::MAGNET:
-                // Handled in updateFruitVelocity()
-                break;
-            case PowerupType::SCORE_BOOST:
-                score += 50; // Add a flat score boost
-                hasPowerup = false; // Consume the powerup immediately
-                break;
-            case PowerupType::FREEZE_TIME:
-                freezeTime = true; // Activate Freeze Time
-                break;
-            default:
-                break;
-        }
-    } else {
-        std::uniform_int_distribution<> distrib(1, 100);
-        if (distrib(randomEngine) <= POWERUP_CHANCE) {
-            hasPowerup = true;
-            lastPowerupTime = std::chrono::system_clock::now();
-            std::uniform_int_distribution<> powerupDistrib(0, static_cast<int>(PowerupType::FREEZE_TIME));
-            currentPowerup.type = static_cast<PowerupType>(powerupDistrib(randomEngine));
-            currentPowerup.duration = 5;
-            
-            // 更新powerup符號
-            switch(currentPowerup.type) {
-                case PowerupType::DOUBLE_POINTS: currentPowerup.description = "2️⃣X"; break;
-                case PowerupType::SLOW_MOTION: currentPowerup.description = "⏱️"; break;
-                case PowerupType::EXTRA_LIFE: currentPowerup.description = "❤️"; break;
-                case PowerupType::MAGNET: currentPowerup.description = "🧲"; break;
-                case PowerupType::SCORE_BOOST: currentPowerup.description = "💯"; break;
-                case PowerupType::FREEZE_TIME: currentPowerup.description = "❄️"; break;
-            }
-            
-            currentPowerup.description = "Power-up: " + currentPowerup.description + " " + powerupTypeToString(currentPowerup.type);
-            stats.totalPowerUpsCollected++;
-            addGameMessage(currentPowerup.description);
-        }
+void Game::endPowerup() {
+    hasPowerup = false;
+    if (currentPowerup.type == PowerupType::FREEZE_TIME) {
+        freezeTime = false; // Deactivate Freeze Time
+    } else if (currentPowerup.type == PowerupType::SLOW_MOTION) {
+        updateGameSpeed();
     }
+    addGameMessage(powerupTypeToString(currentPowerup.type) + " effect ended");
 }
 
 void Game::applyFreezeTime() {
@@ -1156,6 +3450,7 @@ void Game::handleLevelProgression() {
                 int newBasketWidth = std::min(basket.width + 1, 10);
                 basket.width = newBasketWidth;
             }
+            basketIndex.stale = true;
         }
         // Add coins as a level-up reward
         coins += level * 10;  // Example: 10 coins per level
@@ -1189,37 +3484,27 @@ void Game::addGameMessage(const std::string& message) {
     if (gameMessages.size() > 5) gameMessages.pop_back();
 }
 
-void Game::updateEffects() {
-    auto now = std::chrono::system_clock::now();
-    for (auto& effect : activeEffects) {
-        if (effect.active) {
-            if (effect.type == GameEffectType::COLOR_SHIFT) {
-                effect.colorIndex = (effect.colorIndex + 1) % 8;
-            }
-
-            // Decrease the duration of the effect
-            auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(now - effect.startTime);
-            effect.duration = std::max(0, static_cast<int>(10 - elapsed.count()));
-
-            if (effect.duration <= 0) {
-                effect.active = false;
-                effect.colorIndex = 0;
-                addGameMessage(gameEffectTypeToString(effect.type) + " effect ended");
-            }
-        }
-    }
+// Switches an effect on for `seconds` of game time, or restarts its time if it is already on
+void Game::startEffect(size_t index, int seconds) {
+    GameEffect& effect = activeEffects[index];
+    effect.active = true;
+    effect.duration = seconds;
+    effect.endTime = simTime + std::chrono::seconds(seconds);
+    timers.cancel(effect.timer);
+    effect.timer = timers.schedule(effect.endTime, [this, index] {
+        GameEffect& ended = activeEffects[index];
+        ended.active = false;
+        ended.colorIndex = 0;
+        addGameMessage(gameEffectTypeToString(ended.type) + " effect ended");
+    });
 }
 
 void Game::activateRandomEffect() {
     if (!bonusModeActive) { // Prevent effect activation during bonus mode
-        std::uniform_int_distribution<> distrib(1, 100);
-        if (distrib(randomEngine) <= EFFECT_CHANCE) {
-            std::uniform_int_distribution<> effectDistrib(0, activeEffects.size() - 1);
-            int effectIndex = effectDistrib(randomEngine);
+        if (effectRng.chance(EFFECT_CHANCE)) {
+            int effectIndex = effectRng.range(0, activeEffects.size() - 1);
             if (!activeEffects[effectIndex].active) {
-                activeEffects[effectIndex].active = true;
-                activeEffects[effectIndex].duration = 10; // Adjust duration as needed
-                activeEffects[effectIndex].startTime = std::chrono::system_clock::now(); // Set the start time
+                startEffect(effectIndex, EFFECT_DURATION);
                 activeEffects[effectIndex].colorIndex = generateRandomColor();
                 stats.totalEffectsActivated++;
                 addGameMessage("Activated " + gameEffectTypeToString(activeEffects[effectIndex].type) + " effect!");
@@ -1241,168 +3526,352 @@ void Game::activateRandomEffect() {
     }
 }
 
+// Bonus mode comes round every BONUS_INTERVAL seconds of game time
+void Game::scheduleBonusMode(SimClock::time_point when) {
+    timers.schedule(when, [this, when] {
+        activateBonusMode();
+        scheduleBonusMode(when + std::chrono::seconds(BONUS_INTERVAL));
+    });
+}
+
 void Game::activateBonusMode() {
     bonusModeActive = true;
-    bonusModeTimer = 10; // 10 seconds for bonus mode
+    timers.cancel(bonusModeTimer);
+    bonusModeTimer = timers.schedule(simTime + std::chrono::seconds(BONUS_DURATION), [this] {
+        bonusModeActive = false;
+        addGameMessage("Bonus Mode Ended");
+    });
     addGameMessage("Bonus Mode Activated!");
 
     // Activate a random effect during bonus mode
-    std::uniform_int_distribution<> effectDistrib(0, activeEffects.size() - 1);
-    int effectIndex = effectDistrib(randomEngine);
-    activeEffects[effectIndex].active = true;
-    activeEffects[effectIndex].duration = 10; // Match bonus mode duration
-    activeEffects[effectIndex].startTime = std::chrono::system_clock::now(); // Set the start time
+    int effectIndex = effectRng.range(0, activeEffects.size() - 1);
+    startEffect(effectIndex, BONUS_DURATION); // Match bonus mode duration
     addGameMessage("Activated " + gameEffectTypeToString(activeEffects[effectIndex].type) + " effect!");
 
     // Other bonus mode effects can be added here
 }
 
-void Game::updateBonusMode() {
-    if (bonusModeActive) {
-        if (bonusModeTimer <= 0) {
-            bonusModeActive = false;
-            addGameMessage("Bonus Mode Ended");
-        } else {
-            bonusModeTimer--;
-        }
-    }
+// A new challenge is offered every CHALLENGE_INTERVAL seconds of game time
+void Game::scheduleChallenge(SimClock::time_point when) {
+    timers.schedule(when, [this, when] {
+        triggerChallenge();
+        scheduleChallenge(when + std::chrono::seconds(CHALLENGE_INTERVAL));
+    });
 }
 
+// A timer settles the challenge when its time is up: survival is won by
+// lasting that long, anything else is lost by not reaching its target first
 void Game::triggerChallenge() {
-    for (auto& challenge : challenges) {
+    for (size_t i = 0; i < challenges.size(); ++i) {
+        Challenge& challenge = challenges[i];
         if (!challenge.active) {
             challenge.active = true;
             challenge.progress = 0;
-            challenge.startTime = std::chrono::system_clock::now();
+            challenge.startTime = simTime;
             addGameMessage("New Challenge: " + challenge.description);
+            bool survival = challenge.type == ChallengeType::SURVIVAL_CHALLENGE;
+            auto limit = std::chrono::seconds(survival ? challenge.target : CHALLENGE_TIME_LIMIT);
+            timers.cancel(challenge.timer);
+            challenge.timer = timers.schedule(simTime + limit, [this, i, survival] {
+                Challenge& due = challenges[i];
+                if (!due.active) return;
+                due.active = false;
+                addGameMessage((survival ? "Challenge Completed: " : "Challenge Failed: ") + due.description);
+            });
             break;
         }
     }
 }
 
+// Completes the active challenges whose target has been reached
 void Game::updateChallenges() {
-    auto now = std::chrono::system_clock::now();
     for (auto& challenge : challenges) {
-        if (challenge.active) {
-            bool challengeCompleted = false;
-            if (challenge.type == ChallengeType::SPEED_CHALLENGE && challenge.progress >= challenge.target) {
-                challengeCompleted = true;
-            } else if (challenge.type == ChallengeType::COMBO_CHALLENGE && challenge.progress >= challenge.target) {
-                challengeCompleted = true;
-            } else if (challenge.type == ChallengeType::ACCURACY_CHALLENGE && challenge.progress >= challenge.target) {
-                challengeCompleted = true;
-            } else if (challenge.type == ChallengeType::SURVIVAL_CHALLENGE) {
-                auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(now - challenge.startTime);
-                if (elapsed.count() >= challenge.target) {
-                    challengeCompleted = true;
-                }
-            } else if (challenge.type == ChallengeType::COLOR_CHALLENGE && challenge.progress >= challenge.target) {
-                challengeCompleted = true;
-            }
-
-            if (challengeCompleted) {
-                addGameMessage("Challenge Completed: " + challenge.description);
-                // Add reward for completing the challenge (e.g., coins, score bonus, etc.)
-                challenge.active = false;
-            } else if (challenge.type != ChallengeType::SURVIVAL_CHALLENGE) {
-                auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(now - challenge.startTime);
-                if (elapsed.count() >= 60) {
-                    addGameMessage("Challenge Failed: " + challenge.description);
-                    challenge.active = false;
-                }
-            }
+        if (challenge.active && challenge.type != ChallengeType::SURVIVAL_CHALLENGE && challenge.progress >= challenge.target) {
+            addGameMessage("Challenge Completed: " + challenge.description);
+            // Add reward for completing the challenge (e.g., coins, score bonus, etc.)
+            challenge.active = false;
+            timers.cancel(challenge.timer);
         }
     }
 }
 
 void Game::updateParticles() {
-    auto now = std::chrono::system_clock::now();
-    for (auto it = particles.begin(); it != particles.end();) {
-        // Move the particle
-        it->x += static_cast<int>(it->velocity_x);
-        it->y += static_cast<int>(it->velocity_y);
-        // Decrease lifetime
-        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - it->creationTime);
-        it->lifetime = std::max(0, static_cast<int>(1000 - elapsed.count())); // Example lifetime
-
-        if (it->lifetime <= 0 || it->x < 0 || it->x >= SCREEN_WIDTH || it->y < 0 || it->y >= SCREEN_HEIGHT) {
-            it = particles.erase(it);
-        } else {
-            ++it;
+    particles.update(screenWidth, screenHeight);
+}
+
+// Starts a burst of num particles of one type at (x, y). color -1 gives each
+// particle a random colour.
+void Game::addParticles(int x, int y, ParticleType type, int num, int color) {
+    // ASCII glyph (its own glyph id), and the velocity range as a multiple of the step, per type
+    char symbol = '*';
+    int spread = 0;
+    float step = 0.0f;
+    switch (type) {
+        case ParticleType::SPARKLE: spread = 1; step = 0.5f; break;
+        case ParticleType::EXPLOSION: symbol = '.'; spread = 2; step = 0.5f; break;
+        case ParticleType::TRAIL: symbol = '+'; spread = 1; step = 0.3f; break;
+    }
+
+    int first = particles.emit(x, y, static_cast<uint16_t>(symbol), static_cast<uint8_t>(std::max(color, 0)), PARTICLE_LIFETIME_STEPS, num);
+    for (int i = first; i < particles.size(); ++i) {
+        particles.velocityX[i] = cosmeticRng.range(-spread, spread) * step;
+        particles.velocityY[i] = cosmeticRng.range(-spread, spread) * step;
+        if (color == -1) particles.color[i] = static_cast<uint8_t>(generateRandomColor());
+    }
+}
+
+// Plays games first..first+count-1 of the session back to back with the
+// full rule set but no terminal I/O and no sleeping: game time advances one
+// tick per step, as fast as the CPU allows. Nobody moves the baskets, so a
+// game ends once the fruit has been missed MAX_LIVES times, or after
+// HEADLESS_MAX_GAME_SECONDS of game time.
+void Game::playHeadlessGames(uint64_t first, uint64_t count, HeadlessReport& report) {
+    const uint64_t maxTicks = static_cast<uint64_t>(HEADLESS_MAX_GAME_SECONDS) * tickRate;
+    for (uint64_t game = first; game < first + count; ++game) {
+        startNewGame(gameSeedFor(game));
+        while (lives > 0 && gameTicks < maxTicks) {
+            spawnFruit();
+            updateGameLogic();
         }
+        stats.endTime = simTime;
+        stats.gamesPlayed++;
+        checkAchievements();
+        running = false;
+
+        report.games++;
+        report.ticks += gameTicks;
+        if (lives > 0) report.truncatedGames++;
+        report.gameSeconds += std::chrono::duration<double>(stats.endTime - stats.startTime).count();
+        report.totalScore += score;
+        report.maxScore = std::max(report.maxScore, score);
+        report.totalLevel += level;
+        report.maxLevel = std::max(report.maxLevel, level);
+        report.maxCombo = std::max(report.maxCombo, maxCombo);
+        report.fruitsCaught += stats.totalFruitsCaught;
+        report.specialFruitsCaught += stats.totalSpecialFruitsCaught;
+        report.fruitsMissed += stats.totalFruitsMissed;
+        report.powerUpsCollected += stats.totalPowerUpsCollected;
+        report.effectsActivated += stats.totalEffectsActivated;
+        HeadlessReport::count(report.scoreHistogram, std::max(0, score) / SCORE_HISTOGRAM_BUCKET);
+        HeadlessReport::count(report.levelHistogram, std::max(0, level));
+        HeadlessReport::count(report.missHistogram, std::max(0, stats.totalFruitsMissed));
     }
 }
 
-void Game::addParticles(int x, int y, ParticleType type, int num, int color) {
-    for (int i = 0; i < num; ++i) {
-        Particle particle;
-        particle.x = x;
-        particle.y = y;
-        particle.type = type;
-        particle.creationTime = std::chrono::system_clock::now();
+// Plays games 0..games-1 of the session on a pool of worker threads. Each
+// worker owns a Game and claims chunks of game indices from a shared
+// counter; every game is seeded from its index alone, so the totals do not
+// depend on the number of threads.
+HeadlessReport runHeadlessBatch(uint64_t games, int threads, int tickRate, uint64_t seed) {
+    HeadlessReport total = {};
+    std::mutex totalMutex;
+    std::atomic<uint64_t> nextGame(0);
+    auto worker = [&]() {
+        Game game(true);
+        game.setTickRate(tickRate);
+        game.setSeed(seed);
+        HeadlessReport report = {};
+        for (;;) {
+            uint64_t first = nextGame.fetch_add(HEADLESS_CHUNK, std::memory_order_relaxed);
+            if (first >= games) break;
+            game.playHeadlessGames(first, std::min<uint64_t>(HEADLESS_CHUNK, games - first), report);
+        }
+        std::lock_guard<std::mutex> lock(totalMutex);
+        total.merge(report);
+    };
 
-        switch (type) {
-            case ParticleType::SPARKLE:
-                particle.symbol = "*";
-                particle.lifetime = 500; // Lifetime in milliseconds
-                particle.velocity_x = (rand() % 3 - 1) * 0.5; // Random horizontal velocity
-                particle.velocity_y = (rand() % 3 - 1) * 0.5; // Random vertical velocity
-                particle.color = (color == -1) ? generateRandomColor() : color;
-                break;
-            case ParticleType::EXPLOSION:
-                particle.symbol = ".";
-                particle.lifetime = 300;
-                particle.velocity_x = (rand() % 5 - 2) * 0.5; // Wider range for explosion
-                particle.velocity_y = (rand() % 5 - 2) * 0.5;
-                particle.color = (color == -1) ? generateRandomColor() : color;
-                break;
-            case ParticleType::TRAIL:
-                particle.symbol = "+";
-                particle.lifetime = 400;
-                particle.velocity_x = (rand() % 3 - 1) * 0.3;
-                particle.velocity_y = (rand() % 3 - 1) * 0.3;
-                particle.color = (color == -1) ? generateRandomColor() : color;
-                break;
-            case ParticleType::SCORE_POPUP:
-                particle.symbol = std::to_string(currentFruit->points);
-                particle.lifetime = 200;
-                particle.velocity_x = 0;
-                particle.velocity_y = -0.5; // Move upward
-                particle.color = (color == -1) ? generateRandomColor() : color;
-                break;
-            default:
-                particle.symbol = "*";
-                particle.lifetime = 1000;
-                particle.velocity_x = 0;
-                particle.velocity_y = 0;
-                particle.color = 7; // White
+    const auto wallStart = std::chrono::steady_clock::now();
+    std::vector<std::thread> pool;
+    for (int i = 1; i < threads; ++i) pool.emplace_back(worker);
+    worker(); // The calling thread works too
+    for (auto& thread : pool) thread.join();
+    total.wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    return total;
+}
+
+// Applies one key of in-game input. Live, recorded and replayed input all go
+// through here.
+void Game::applyInput(char input) {
+    switch (input) {
+        case 'a':
+            for (auto& basket : baskets) {
+                basket.x = std::max(basket.x - 1, basket.width / 2);
+            }
+            basketIndex.stale = true;
+            break;
+        case 'd':
+            for (auto& basket : baskets) {
+                basket.x = std::min(basket.x + 1, screenWidth - 1 - basket.width / 2);
+            }
+            basketIndex.stale = true;
+            break;
+        case 'p':
+            isPaused = !isPaused;
+            if (!isPaused) addGameMessage("Game Resumed");
+            break;
+        case 'q':
+            running = false;
+            break;
+        default:
+            break;
+    }
+}
+
+// Logs an input against the tick it is applied before
+void Game::recordEvent(char key) {
+    if (recordPath.empty()) return;
+    recording.events.push_back({gameTicks, key, screenWidth, screenHeight});
+}
+
+// Applies the replay events due before the next tick and returns the index
+// of the first one still to come.
+size_t Game::applyReplayEvents(const Replay& replay, size_t next) {
+    while (next < replay.events.size() && replay.events[next].tick <= gameTicks) {
+        const Replay::Event& event = replay.events[next++];
+        if (event.key == 'r') {
+            resizePlayfield(event.width, event.height);
+        } else {
+            applyInput(event.key);
         }
-        particles.push_back(particle);
     }
+    isPaused = false; // No ticks pass while paused, so a pause left open is just where the recording stopped
+    return next;
+}
+
+GameOutcome Game::currentOutcome() const {
+    return {gameTicks, score, level, lives, maxCombo, stats.totalFruitsCaught, stats.totalSpecialFruitsCaught,
+            stats.totalFruitsMissed, stats.totalPowerUpsCollected, stats.totalEffectsActivated};
 }
 
-void Game::applyScreenShake() {
-    if (screenShakeIntensity > 0) {
-        int shakeX = (rand() % (2 * screenShakeIntensity + 1)) - screenShakeIntensity;
-        int shakeY = (rand() % (2 * screenShakeIntensity + 1)) - screenShakeIntensity;
+// Runs the current game on the fixed-timestep loop until it ends or is quit.
+// Wall time is banked and spent in whole ticks, so a slow iteration is caught
+// up on instead of slowing the game. Input comes from the keyboard, or from
+// the replay's log when one is given; the keyboard can then only quit.
+void Game::playLoop(const Replay* playback) {
+    const auto period = tickPeriod();
+    auto previous = std::chrono::steady_clock::now();
+    std::chrono::nanoseconds accumulator(0);
+    size_t nextEvent = 0;
+    frame.invalidate(); // Menus have drawn over the playfield
+    tickStart = previous;
+    publishSnapshot();
+    startRenderThread();
+    input.start();
+    while (running && lives > 0 && (!playback || gameTicks < playback->outcome.ticks)) {
+        if (terminalResized.exchange(false)) {
+            if (playback) {
+                queryTerminalSize(terminalColumns, terminalRows); // The playfield keeps the recorded size
+            } else {
+                int oldWidth = screenWidth, oldHeight = screenHeight;
+                updateLayout();
+                if (screenWidth != oldWidth || screenHeight != oldHeight) recordEvent('r');
+            }
+            publishSnapshot();
+        }
+        if (phaseReportRequested.exchange(false)) {
+            std::ofstream file(PHASE_REPORT_FILE, std::ios::app);
+            file << getCurrentTimestamp() << " tick " << gameTicks << "\n" << formatPhaseReport(phaseTimes) << "\n";
+            addGameMessage(file ? "Phase times written to " + PHASE_REPORT_FILE : "Could not write " + PHASE_REPORT_FILE);
+        }
+        if (isPaused) {
+            drainInput(playback, std::chrono::steady_clock::now());
+            if (isPaused) {
+                // Nothing moves and nothing is drawn until a key or a signal comes in
+                input.waitForKey(signalWakeFds[0]);
+                drainSignalWakes();
+                continue;
+            }
+            previous = std::chrono::steady_clock::now(); // Time spent paused is not owed to the simulation
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        accumulator = std::min<std::chrono::nanoseconds>(accumulator + (now - previous), MAX_TICK_BACKLOG);
+        previous = now;
+        bool ticked = false;
+        bool wasPaused = isPaused;
+        while (!isPaused && accumulator >= period && running && lives > 0) {
+            if (playback) {
+                nextEvent = applyReplayEvents(*playback, nextEvent);
+                if (!running || gameTicks >= playback->outcome.ticks) break;
+            }
+            // Keys that arrived in the stretch of wall time this tick stands for
+            drainInput(playback, now - accumulator + period);
+            if (isPaused || !running) break;
+            {
+                PhaseTimer timer(phaseTimes, PHASE_SPAWN);
+                spawnFruit();
+            }
+            {
+                PhaseTimer timer(phaseTimes, PHASE_UPDATE);
+                updateGameLogic();
+            }
+            accumulator -= period;
+            ticked = true;
+        }
+        if (ticked) tickStart = now - accumulator;
+        if (ticked || isPaused != wasPaused) publishSnapshot();
+        PhaseTimer timer(phaseTimes, PHASE_SLEEP);
+        std::this_thread::sleep_until(now + (period - accumulator));
+    }
+    input.stop();
+    publishSnapshot();
+    stopRenderThread();
+}
 
-        // Move cursor position for shake effect
-        std::cout << "\033[" << shakeY << ";" << shakeX << "H";
+// Applies the queued keys that arrived before `until`. During a replay the
+// keyboard can only quit.
+void Game::drainInput(const Replay* playback, std::chrono::steady_clock::time_point until) {
+    PhaseTimer timer(phaseTimes, PHASE_INPUT);
+    while (const InputEvent* event = input.front()) {
+        if (event->time > until) break;
+        char key = event->key;
+        input.pop();
+        if (playback) {
+            if (key == 'q') running = false;
+        } else if (std::string_view("adpq").find(key) != std::string_view::npos) {
+            recordEvent(key);
+            applyInput(key);
+        }
+        if (!running) break;
+    }
+}
 
-        screenShakeIntensity--;
+// Plays a recorded game again from its settings, seed and input log, either
+// in the terminal at the recorded tick rate or headless as fast as possible.
+// Returns how it ended, for comparison with the recorded outcome.
+GameOutcome Game::playReplay(const Replay& replay, bool headless) {
+    setTickRate(replay.tickRate);
+    difficultyLevel = replay.difficulty;
+    resizePlayfield(replay.width, replay.height);
+    startNewGame(replay.seed);
+    if (headless) {
+        size_t next = 0;
+        while (running && lives > 0 && gameTicks < replay.outcome.ticks) {
+            next = applyReplayEvents(replay, next);
+            if (!running) break;
+            spawnFruit();
+            updateGameLogic();
+        }
+    } else {
+        playLoop(&replay);
     }
+    running = false;
+    return currentOutcome();
 }
 
 void Game::run() {
+    loadHighScores(); // Only interactive play keeps high scores; headless games never touch the file
     while (true) {
+        if (terminalResized.exchange(false)) updateLayout();
         switch (currentState) {
             case GameState::MENU:
                 drawMenu();
                 {
-                    char choice = getch();
+                    int choice = getch();
+                    if (choice == KEY_END_OF_INPUT) return;
                     switch (choice) {
                         case '1':
-                            startNewGame();
+                            startNewGame(gameSeedFor(gamesStarted++));
                             currentState = GameState::PLAYING;
                             break;
                         case '2':
@@ -1426,110 +3895,67 @@ void Game::run() {
                 break;
             case GameState::SHOP:
                 displayShop();
-                currentState = GameState::MENU;
+                if (int key = getch(); key == KEY_END_OF_INPUT) {
+                    return;
+                } else if (key != KEY_REDRAW) {
+                    buyShopItem(static_cast<char>(key));
+                    currentState = GameState::MENU;
+                }
                 break;
             case GameState::PLAYING:
-                if (!running) {
-                    // Reinitialize the game state if starting a new game
-                    lives = MAX_LIVES;
-                    score = 0;
-                    level = 1;
-                    combo = 0;
-                    maxCombo = 0;
-                    consecutiveCatches = 0;
-                    comboMultiplier = 1;
-                    totalFruits = 0;
-                    gameSpeed = std::max(20, 250 - (level * 10) - (difficultyLevel * 25)); // Reset game speed
-                    fruitY = 0; // Reset fruit position
-                    fruitX = SCREEN_WIDTH / 2; // Reset fruit position
-                    stats.totalFruitsCaught = 0;
-                    stats.totalSpecialFruitsCaught = 0;
-                    stats.totalFruitsMissed = 0;
-                    stats.totalPowerUpsCollected = 0;
-                    stats.totalEffectsActivated = 0;
-                    stats.startTime = std::chrono::system_clock::now(); // Reset game start time
-                    isPaused = false;
-                    bonusModeActive = false; // Reset bonus mode
-                    bonusModeTimer = 0; // Reset bonus mode timer
-                    initializeBaskets();    // Reinitialize baskets
-                    if (currentFruit) {    // Clear any existing fruit
-                        delete currentFruit;
-                        currentFruit = nullptr;
-                    }
-                    challenges.clear();    // Clear challenges
-                    for (int i = 0; i < 3; ++i) {
-                        std::uniform_int_distribution<> dist(0, static_cast<int>(ChallengeType::COLOR_CHALLENGE));
-                        ChallengeType type = static_cast<ChallengeType>(dist(randomEngine));
-                        challenges.emplace_back(type);
-                    }
-                    for (auto& effect : activeEffects) { // Reset active effects
-                        effect.active = false;
-                        effect.duration = 0;
-                    }
-                    running = true;
-                }
-                while (running && lives > 0) {
-                    spawnFruit();
-                    drawGame();
-                    if (kbhit()) {
-                        char input = getch();
-                        if (input == 'a' || input == 'A') {
-                            for (auto& basket : baskets) {
-                                basket.x = std::max(basket.x - 1, basket.width / 2);
-                            }
-                        } else if (input == 'd' || input == 'D') {
-                            for (auto& basket : baskets) {
-                                basket.x = std::min(basket.x + 1, SCREEN_WIDTH - 1 - basket.width / 2);
-                            }
-                        } else if (input == 'p' || input == 'P') {
-                            isPaused = !isPaused;
-                            if (isPaused) {
-                                std::cout << "\nGame Paused. Press any key to continue...\n";
-                            } else {
-                                addGameMessage("Game Resumed");
-                            }
-                            while (isPaused && !kbhit()) {
-                                std::this_thread::sleep_for(std::chrono::milliseconds(100));
-                            }
-                        } else if (input == 'q' || input == 'Q') {
-                            running = false;
-                        }
-                    }
-
-                    if (!isPaused) {
-                        updateGameLogic();
-                        std::this_thread::sleep_for(std::chrono::milliseconds(gameSpeed));
-                    }
+                playLoop(nullptr);
+                if (!recordPath.empty()) {
+                    recording.outcome = currentOutcome();
+                    recordStatus = saveReplay(recordPath, recording) ? "Replay saved to " + recordPath
+                                                                     : "Could not write replay " + recordPath;
                 }
-
-                if (lives <= 0) {
-                    currentState = GameState::GAME_OVER;
+                running = false;
+                if (lives > 0) {
+                    // Quitting goes back to the menu rather than straight into a new game
+                    currentState = GameState::MENU;
+                    break;
                 }
-                break;
-            case GameState::GAME_OVER:
-                drawGameOver();
+                // Done once here, since the game over screen may be drawn again
                 manageRecentScores();
                 saveHighScore(score);
                 stats.gamesPlayed++;
                 checkAchievements(); // Check for achievements at the end of the game
-                running = false; // Ensure the game is set to not running
-                {
-                    std::cout << "\nPress any key to return to the main menu...\n";
-                    getch();
+                currentState = GameState::GAME_OVER;
+                break;
+            // Each screen below waits for a key; KEY_REDRAW means draw it again
+            case GameState::GAME_OVER:
+                drawGameOver();
+                presentOutput();
+                if (int key = getch(); key == KEY_END_OF_INPUT) {
+                    return;
+                } else if (key != KEY_REDRAW) {
                     currentState = GameState::MENU;
                 }
                 break;
             case GameState::INSTRUCTIONS:
                 drawInstructions();
-                currentState = GameState::MENU;
+                if (int key = getch(); key == KEY_END_OF_INPUT) {
+                    return;
+                } else if (key != KEY_REDRAW) {
+                    currentState = GameState::MENU;
+                }
                 break;
             case GameState::HIGH_SCORES:
                 drawHighScores();
-                currentState = GameState::MENU;
+                if (int key = getch(); key == KEY_END_OF_INPUT) {
+                    return;
+                } else if (key != KEY_REDRAW) {
+                    currentState = GameState::MENU;
+                }
                 break;
             case GameState::SETTINGS:
                 drawSettings();
-                currentState = GameState::MENU;
+                if (int choice = getch(); choice == KEY_END_OF_INPUT) {
+                    return;
+                } else if (choice != KEY_REDRAW) {
+                    changeSetting(static_cast<char>(choice));
+                    currentState = GameState::MENU;
+                }
                 break;
             // ... (Add other cases as needed)
         }
@@ -1546,16 +3972,18 @@ void Game::manageRecentScores() {
 
 void Game::drawSettings() {
     clearScreen();
-    printCenteredText("Settings", 3);
-    printCenteredText("1. Screen Size: " + std::to_string(SCREEN_WIDTH) + "x" + std::to_string(SCREEN_HEIGHT), 5);
-    printCenteredText("2. Difficulty: " + DIFFICULTY_LEVELS[difficultyLevel], 6);
-    printCenteredText("3. Sound: " + std::string(musicEnabled ? "On" : "Off"), 7);
-    printCenteredText("4. Effects: " + std::string(effectsEnabled ? "On" : "Off"), 8);
-    printCenteredText("5. Back to Menu", 10);
-    
-    std::cout << "\nEnter your choice (1-5): ";
-    char choice = getch();
-    
+    printCenteredText("Settings", 1);
+    printCenteredText("1. Screen Size: " + std::to_string(screenWidth) + "x" + std::to_string(screenHeight) + " (follows terminal)", 3);
+    printCenteredText("2. Difficulty: " + DIFFICULTY_LEVELS[difficultyLevel], 4);
+    printCenteredText("3. Sound: " + std::string(musicEnabled ? "On" : "Off"), 5);
+    printCenteredText("4. Effects: " + std::string(effectsEnabled ? "On" : "Off"), 6);
+    printCenteredText("5. Frame Rate: " + std::to_string(FRAME_RATES[frameRateIndex]) + " FPS", 7);
+    printCenteredText("6. Back to Menu", 8);
+    printCenteredText("Enter your choice (1-6): ", 10);
+    presentOutput();
+}
+
+void Game::changeSetting(char choice) {
     switch(choice) {
         case '2':
             difficultyLevel = (difficultyLevel + 1) % DIFFICULTY_LEVELS.size();
@@ -1567,13 +3995,197 @@ void Game::drawSettings() {
             effectsEnabled = !effectsEnabled;
             break;
         case '5':
+            frameRateIndex = (frameRateIndex + 1) % FRAME_RATES.size();
+            break;
+        case '6':
         default:
             break;
     }
 }
 
-int main() {
+// Value below which the given fraction of games fall, from a histogram
+size_t histogramPercentile(const std::vector<uint64_t>& histogram, uint64_t games, double fraction) {
+    uint64_t target = static_cast<uint64_t>(std::ceil(fraction * games));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < histogram.size(); ++i) {
+        seen += histogram[i];
+        if (seen >= target && seen > 0) return i;
+    }
+    return histogram.empty() ? 0 : histogram.size() - 1;
+}
+
+void printHistogram(const char* name, const std::vector<uint64_t>& histogram, uint64_t games, int bucket) {
+    std::printf("\"%s\": {\"bucket\": %d, \"p50\": %zu, \"p90\": %zu, \"p99\": %zu, \"counts\": [", name, bucket,
+                histogramPercentile(histogram, games, 0.5) * bucket, histogramPercentile(histogram, games, 0.9) * bucket,
+                histogramPercentile(histogram, games, 0.99) * bucket);
+    for (size_t i = 0; i < histogram.size(); ++i) {
+        std::printf(i ? ", %llu" : "%llu", static_cast<unsigned long long>(histogram[i]));
+    }
+    std::printf("]}");
+}
+
+// Headless results as a single JSON object on stdout
+void printHeadlessReport(const HeadlessReport& report, int tickRate, uint64_t seed, int threads) {
+    const double games = std::max<uint64_t>(report.games, 1);
+    const double wall = std::max(report.wallSeconds, 1e-9);
+    std::printf("{\"seed\": %llu, \"games\": %llu, \"threads\": %d, \"ticks\": %llu, \"tick_rate\": %d, \"truncated_games\": %llu, "
+                "\"wall_seconds\": %.3f, \"game_seconds\": %.1f, \"ticks_per_second\": %.0f, \"games_per_second\": %.1f, "
+                "\"score\": {\"total\": %lld, \"mean\": %.2f, \"max\": %d}, "
+                "\"level\": {\"mean\": %.2f, \"max\": %d}, \"max_combo\": %d, "
+                "\"fruits_caught\": %lld, \"special_fruits_caught\": %lld, \"fruits_missed\": %lld, "
+                "\"power_ups_collected\": %lld, \"effects_activated\": %lld, ",
+                static_cast<unsigned long long>(seed), static_cast<unsigned long long>(report.games), threads,
+                static_cast<unsigned long long>(report.ticks), tickRate,
+                static_cast<unsigned long long>(report.truncatedGames), report.wallSeconds, report.gameSeconds,
+                report.ticks / wall, report.games / wall,
+                report.totalScore, report.totalScore / games, report.maxScore,
+                report.totalLevel / games, report.maxLevel, report.maxCombo,
+                report.fruitsCaught, report.specialFruitsCaught, report.fruitsMissed,
+                report.powerUpsCollected, report.effectsActivated);
+    std::printf("\"distributions\": {");
+    printHistogram("score", report.scoreHistogram, report.games, SCORE_HISTOGRAM_BUCKET);
+    std::printf(", ");
+    printHistogram("level", report.levelHistogram, report.games, 1);
+    std::printf(", ");
+    printHistogram("fruits_missed", report.missHistogram, report.games, 1);
+    std::printf("}}\n");
+}
+
+// Times one particle update with every kernel this CPU supports, at several
+// particle counts, on the same particles, and prints the results as JSON
+void runParticleBenchmark() {
+    const int width = 200; // A large playfield, so particles die both of age and by leaving it
+    const int height = 50;
+    const auto kernels = particleKernels();
+    std::printf("{\"selected\": \"%s\", \"results\": [", ACTIVE_PARTICLE_KERNEL.name);
+    bool first = true;
+    for (int particles : {1000, 10000, 1000000}) {
+        ParticleSystem start(particles);
+        Rng rng(static_cast<uint64_t>(particles));
+        start.emit(0, 0, '*', 0, PARTICLE_LIFETIME_STEPS, particles);
+        for (int i = 0; i < particles; ++i) {
+            start.x[i] = static_cast<int16_t>(rng.range(0, width - 1));
+            start.y[i] = static_cast<int16_t>(rng.range(0, height - 1));
+            start.velocityX[i] = rng.range(-2, 2) * 0.5f;
+            start.velocityY[i] = rng.range(-2, 2) * 0.5f;
+            start.stepsLeft[i] = static_cast<uint8_t>(rng.range(1, PARTICLE_LIFETIME_STEPS));
+        }
+        const int updates = std::max(20, 20000000 / particles);
+        ParticleSystem work(particles);
+        for (const auto& kernel : kernels) {
+            if (!kernel.supported) continue;
+            std::chrono::nanoseconds total{0};
+            for (int u = 0; u < updates; ++u) {
+                work = start;
+                auto begin = std::chrono::steady_clock::now();
+                work.update(width, height, kernel.step);
+                total += std::chrono::steady_clock::now() - begin;
+            }
+            double perUpdate = static_cast<double>(total.count()) / updates;
+            std::printf("%s{\"particles\": %d, \"kernel\": \"%s\", \"updates\": %d, \"ns_per_update\": %.0f, "
+                        "\"ns_per_particle\": %.3f, \"survivors\": %d}",
+                        first ? "" : ", ", particles, kernel.name, updates, perUpdate, perUpdate / particles, work.size());
+            first = false;
+        }
+    }
+    std::printf("]}\n");
+}
+
+// Replay verification as a single JSON object on stdout
+void printReplayResult(const GameOutcome& recorded, const GameOutcome& replayed) {
+    auto print = [](const char* name, const GameOutcome& o) {
+        std::printf("\"%s\": {\"ticks\": %llu, \"score\": %d, \"level\": %d, \"lives\": %d, \"max_combo\": %d, "
+                    "\"fruits_caught\": %d, \"special_fruits_caught\": %d, \"fruits_missed\": %d, "
+                    "\"power_ups_collected\": %d, \"effects_activated\": %d}",
+                    name, static_cast<unsigned long long>(o.ticks), o.score, o.level, o.lives, o.maxCombo, o.fruitsCaught,
+                    o.specialFruitsCaught, o.fruitsMissed, o.powerUpsCollected, o.effectsActivated);
+    };
+    std::printf("{\"match\": %s, ", recorded == replayed ? "true" : "false");
+    print("recorded", recorded);
+    std::printf(", ");
+    print("replayed", replayed);
+    std::printf("}\n");
+}
+
+int main(int argc, char* argv[]) {
+    int tickRate = DEFAULT_TICK_RATE;
+    bool headless = false;
+    unsigned long long games = 1000;
+    int threads = std::max(1u, std::thread::hardware_concurrency());
+    bool seeded = false;
+    uint64_t seed = 0;
+    std::string recordPath;
+    std::string replayPath;
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        if (arg == "--tick-rate" && i + 1 < argc) {
+            tickRate = std::atoi(argv[++i]);
+        } else if (arg == "--seed" && i + 1 < argc) {
+            seed = std::strtoull(argv[++i], nullptr, 10);
+            seeded = true;
+        } else if (arg == "--headless") {
+            headless = true;
+        } else if (arg == "--games" && i + 1 < argc) {
+            games = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--threads" && i + 1 < argc) {
+            threads = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--record" && i + 1 < argc) {
+            recordPath = argv[++i];
+        } else if (arg == "--replay" && i + 1 < argc) {
+            replayPath = argv[++i];
+        } else if (arg == "--bench-particles") {
+            runParticleBenchmark();
+            return 0;
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--tick-rate N] [--seed N] [--record FILE] [--replay FILE] [--headless [--games N] [--threads N]] [--bench-particles]\n"
+                      << "  --tick-rate N  simulation ticks per second (" << MIN_TICK_RATE << "-" << MAX_TICK_RATE
+                      << ", default " << DEFAULT_TICK_RATE << ")\n"
+                      << "  --seed N       seed for every random decision, to reproduce a run (default: random)\n"
+                      << "  --headless     play games without a terminal as fast as possible and print stats as JSON\n"
+                      << "  --games N      number of headless games (default 1000)\n"
+                      << "  --threads N    headless worker threads (default: one per core)\n"
+                      << "  --record FILE  save each finished game to FILE for replay\n"
+                      << "  --replay FILE  play a recorded game again, in the terminal or with --headless at full speed,\n"
+                      << "                 and check that it ends exactly as recorded\n"
+                      << "  --bench-particles  time the particle update kernels and print the results as JSON\n";
+            return 1;
+        }
+    }
+
+    if (!replayPath.empty()) {
+        Replay replay;
+        if (!loadReplay(replayPath, replay)) {
+            std::cerr << "Could not read replay " << replayPath << "\n";
+            return 1;
+        }
+        GameOutcome replayed;
+        if (headless) {
+            Game game(true);
+            replayed = game.playReplay(replay, true);
+        } else {
+            TerminalSession terminal;
+            Game game(true); // The recorded playfield size is kept whatever the terminal size
+            game.attachTerminal();
+            game.setSynchronizedOutput(terminal.supportsSynchronizedOutput());
+            replayed = game.playReplay(replay, false);
+        }
+        printReplayResult(replay.outcome, replayed);
+        return replay.outcome == replayed ? 0 : 2;
+    }
+
+    if (headless) {
+        if (!seeded) seed = randomSeed();
+        tickRate = std::clamp(tickRate, MIN_TICK_RATE, MAX_TICK_RATE);
+        printHeadlessReport(runHeadlessBatch(games, threads, tickRate, seed), tickRate, seed, threads);
+        return 0;
+    }
+
+    TerminalSession terminal;
     Game game;
+    game.setSynchronizedOutput(terminal.supportsSynchronizedOutput());
+    game.setTickRate(tickRate);
+    if (seeded) game.setSeed(seed);
+    game.setRecordPath(recordPath);
     game.run();
     return 0;
 }
@@ -0,0 +1,68 @@
+// BasketIndex must answer exactly what a scan over every basket would.
+#include "check.h"
+
+// The basket of the given type covering column x, earliest first, or -1
+int scanCatcher(const std::vector<Basket>& baskets, int type, int x) {
+    for (size_t i = 0; i < baskets.size(); ++i) {
+        const Basket& basket = baskets[i];
+        if (static_cast<int>(basket.type) == type && x >= basket.x - basket.width / 2 && x <= basket.x + basket.width / 2) return static_cast<int>(i);
+    }
+    return -1;
+}
+
+// The basket of the given type nearest to column x, earliest on a tie, or -1
+int scanNearest(const std::vector<Basket>& baskets, int type, int x) {
+    int best = -1;
+    int bestDistance = 0;
+    for (size_t i = 0; i < baskets.size(); ++i) {
+        if (static_cast<int>(baskets[i].type) != type) continue;
+        int distance = std::abs(baskets[i].x - x);
+        if (best < 0 || distance < bestDistance) {
+            best = static_cast<int>(i);
+            bestDistance = distance;
+        }
+    }
+    return best;
+}
+
+int main() {
+    // Equally far baskets on either side of the fruit: the one that comes first wins
+    const FruitType apple = FruitType::APPLE;
+    BasketIndex index;
+    index.rebuild({Basket(10, 4, apple), Basket(30, 4, apple)}, 40, FRUIT_KINDS);
+    CHECK(index.nearest(0, 20) == 0);
+    index.rebuild({Basket(30, 4, apple), Basket(10, 4, apple)}, 40, FRUIT_KINDS);
+    CHECK(index.nearest(0, 20) == 0);
+    // Several baskets in the nearest column on the left
+    index.rebuild({Basket(30, 4, apple), Basket(10, 4, apple), Basket(10, 2, apple)}, 40, FRUIT_KINDS);
+    CHECK(index.nearest(0, 20) == 0);
+    CHECK(index.nearest(0, 19) == 1);
+    // Outside the playfield, or a type with no basket
+    CHECK(index.catcher(0, -1) == -1);
+    CHECK(index.catcher(0, 40) == -1);
+    CHECK(index.catcher(FRUIT_KINDS, 10) == -1);
+    CHECK(index.nearest(1, 10) == -1);
+
+    // Random layouts, overlapping and partly off the playfield, against the scan
+    Rng rng(7);
+    int mismatches = 0;
+    for (int trial = 0; trial < 500; ++trial) {
+        int width = rng.range(MIN_SCREEN_WIDTH, 300);
+        int count = rng.range(0, 100);
+        std::vector<Basket> baskets;
+        for (int i = 0; i < count; ++i) {
+            baskets.emplace_back(rng.range(-5, width + 5), rng.range(1, 10), static_cast<FruitType>(rng.range(0, FRUIT_KINDS - 1)));
+        }
+        index.rebuild(baskets, width, FRUIT_KINDS);
+        for (int type = 0; type < FRUIT_KINDS; ++type) {
+            for (int x = 0; x < width; ++x) {
+                mismatches += index.catcher(type, x) != scanCatcher(baskets, type, x);
+                mismatches += index.nearest(type, x) != scanNearest(baskets, type, x);
+            }
+        }
+    }
+    CHECK(mismatches == 0);
+
+    if (checkFailures == 0) std::printf("basket_index_test: ok\n");
+    return checkFailures == 0 ? 0 : 1;
+}
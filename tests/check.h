@@ -0,0 +1,21 @@
+// Minimal checks for the tests in this directory. Each test includes
+// main.cpp directly, so it sees the game's internals without any of them
+// having to be split out into headers.
+#pragma once
+
+#include <cstdio>
+
+inline int checkFailures = 0;
+
+#define CHECK(condition)                                                                    \
+    do {                                                                                    \
+        if (!(condition)) {                                                                 \
+            std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            checkFailures++;                                                                \
+        }                                                                                   \
+    } while (0)
+
+// The game's own main() is renamed so the test can supply its own
+#define main fruit_game_main
+#include "../main.cpp"
+#undef main
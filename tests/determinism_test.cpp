@@ -0,0 +1,59 @@
+// A game is a function of its seed, tick rate and inputs alone: playing it
+// again, on another Game or after other games, must end exactly the same,
+// and a headless batch must add up the same however many threads play it.
+#include "check.h"
+
+// Plays one game with no input until it ends, as --headless --replay would
+GameOutcome playOut(Game& game, uint64_t seed, int tickRate) {
+    Replay replay;
+    replay.seed = seed;
+    replay.tickRate = tickRate;
+    replay.outcome.ticks = static_cast<uint64_t>(HEADLESS_MAX_GAME_SECONDS) * tickRate;
+    return game.playReplay(replay, true);
+}
+
+// Everything but the wall time. Game seconds are summed in a different order
+// per thread count, so they only have to agree to rounding.
+bool sameTotals(const HeadlessReport& a, const HeadlessReport& b) {
+    return a.games == b.games && a.ticks == b.ticks && a.truncatedGames == b.truncatedGames &&
+           std::abs(a.gameSeconds - b.gameSeconds) <= 1e-9 * a.gameSeconds && a.totalScore == b.totalScore &&
+           a.maxScore == b.maxScore && a.totalLevel == b.totalLevel && a.maxLevel == b.maxLevel &&
+           a.maxCombo == b.maxCombo && a.fruitsCaught == b.fruitsCaught && a.specialFruitsCaught == b.specialFruitsCaught &&
+           a.fruitsMissed == b.fruitsMissed && a.powerUpsCollected == b.powerUpsCollected &&
+           a.effectsActivated == b.effectsActivated && a.scoreHistogram == b.scoreHistogram &&
+           a.levelHistogram == b.levelHistogram && a.missHistogram == b.missHistogram;
+}
+
+int main() {
+    const uint64_t seeds[] = {1, 42, 0xdeadbeefcafe};
+    int distinct = 0;
+    for (int tickRate : {DEFAULT_TICK_RATE, 144}) {
+        for (uint64_t seed : seeds) {
+            Game first(true), second(true);
+            GameOutcome expected = playOut(first, seed, tickRate);
+            CHECK(expected.ticks > 0);
+            CHECK(playOut(second, seed, tickRate) == expected);
+            // A Game that has played another game first starts afresh
+            Game reused(true);
+            playOut(reused, seed + 1, tickRate);
+            CHECK(playOut(reused, seed, tickRate) == expected);
+            distinct += playOut(second, seed + 1, tickRate) != expected;
+        }
+    }
+    // Different seeds are different games
+    CHECK(distinct > 0);
+
+    // A batch adds up to the same totals on any number of threads. 200 games
+    // is several HEADLESS_CHUNKs, so the threads really do share the work.
+    const HeadlessReport single = runHeadlessBatch(200, 1, DEFAULT_TICK_RATE, 7);
+    CHECK(single.games == 200);
+    for (int threads : {2, 3, 8}) {
+        bool same = sameTotals(single, runHeadlessBatch(200, threads, DEFAULT_TICK_RATE, 7));
+        if (!same) std::fprintf(stderr, "a batch on %d threads differs from one on a single thread\n", threads);
+        CHECK(same);
+    }
+    CHECK(!sameTotals(single, runHeadlessBatch(200, 1, DEFAULT_TICK_RATE, 8)));
+
+    if (checkFailures == 0) std::printf("determinism_test: ok\n");
+    return checkFailures == 0 ? 0 : 1;
+}
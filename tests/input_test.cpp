@@ -0,0 +1,94 @@
+// The keyboard path: KeyDecoder turning terminal bytes into keys, and the
+// SpscRing that carries them from the input thread to the play loop.
+#include "check.h"
+
+// Every key the bytes decode to, fed one at a time
+std::string decode(KeyDecoder& decoder, std::string_view bytes) {
+    std::string keys;
+    for (char byte : bytes) {
+        if (char key = decoder.feed(static_cast<unsigned char>(byte))) keys += key;
+    }
+    return keys;
+}
+
+int main() {
+    KeyDecoder decoder;
+    // Plain keys come through lower-cased
+    CHECK(decode(decoder, "adPQ") == "adpq");
+    // Arrow keys, in normal and application cursor mode, and with modifiers
+    CHECK(decode(decoder, "\033[D\033[C") == "ad");
+    CHECK(decode(decoder, "\033OD\033OC") == "ad");
+    CHECK(decode(decoder, "\033[1;5D") == "a");
+    CHECK(!decoder.midSequence());
+    // Other sequences are swallowed whole, parameters and all
+    CHECK(decode(decoder, "\033[A\033[B\033[15~x") == "x");
+
+    // A sequence split across reads completes on the next one
+    CHECK(decode(decoder, "\033").empty());
+    CHECK(decoder.midSequence());
+    CHECK(decode(decoder, "[").empty());
+    CHECK(decoder.midSequence());
+    CHECK(decode(decoder, "C") == "d");
+    CHECK(!decoder.midSequence());
+
+    // A lone Escape followed by a key is just the key
+    CHECK(decode(decoder, "\033q") == "q");
+    CHECK(decode(decoder, "\033\033[D") == "a");
+    // A lone Escape that times out (the input thread resets the decoder) leaves nothing behind
+    CHECK(decode(decoder, "\033").empty());
+    decoder.reset();
+    CHECK(!decoder.midSequence());
+    CHECK(decode(decoder, "[D") == "[d");
+
+    // The ring holds exactly Capacity items and refuses more until one is taken
+    SpscRing<int, 4> ring;
+    CHECK(ring.front() == nullptr);
+    for (int i = 0; i < 4; ++i) CHECK(ring.push(i));
+    CHECK(!ring.push(4));
+    CHECK(ring.front() && *ring.front() == 0);
+    ring.pop();
+    CHECK(ring.push(4));
+    CHECK(!ring.push(5));
+    // Wraps around the slots many times over, first in first out
+    int next = 1, pushed = 5;
+    for (int round = 0; round < 100; ++round) {
+        for (int i = 0; i < round % 4 + 1 && ring.front(); ++i) {
+            CHECK(*ring.front() == next++);
+            ring.pop();
+        }
+        while (ring.push(pushed)) pushed++;
+    }
+    while (const int* item = ring.front()) {
+        CHECK(*item == next++);
+        ring.pop();
+    }
+    CHECK(next == pushed);
+    ring.push(7);
+    ring.clear();
+    CHECK(ring.front() == nullptr);
+
+    // One producer thread, one consumer: every item arrives once and in order
+    SpscRing<uint32_t, 64> shared;
+    const uint32_t total = 1 << 20;
+    std::thread producer([&] {
+        for (uint32_t i = 0; i < total; ++i) {
+            while (!shared.push(i)) std::this_thread::yield();
+        }
+    });
+    uint32_t expected = 0;
+    bool ordered = true;
+    while (expected < total) {
+        if (const uint32_t* item = shared.front()) {
+            ordered = ordered && *item == expected;
+            expected++;
+            shared.pop();
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+    CHECK(ordered);
+
+    if (checkFailures == 0) std::printf("input_test: ok\n");
+    return checkFailures == 0 ? 0 : 1;
+}
@@ -0,0 +1,54 @@
+// LatencyHistogram percentiles on samples whose answer is known: exact below
+// 128 ns, the top of the sample's bucket (under 1.6% above it) beyond.
+#include "check.h"
+
+// True if reported is value or at most 1/64 above it
+bool withinBucket(uint64_t reported, uint64_t value) {
+    return reported >= value && reported - value <= value / 64;
+}
+
+int main() {
+    LatencyHistogram histogram;
+    CHECK(histogram.count() == 0);
+    CHECK(histogram.percentile(0.5) == 0);
+
+    // 1..100 ns are all exact
+    for (uint64_t ns = 1; ns <= 100; ++ns) histogram.record(ns);
+    CHECK(histogram.count() == 100);
+    CHECK(histogram.percentile(0.5) == 50);
+    CHECK(histogram.percentile(0.99) == 99);
+    CHECK(histogram.percentile(1.0) == 100);
+    CHECK(histogram.percentile(0.0) == 1);
+    CHECK(histogram.max() == 100);
+
+    // A typical frame time distribution with a slow tail
+    histogram.reset();
+    CHECK(histogram.count() == 0 && histogram.max() == 0);
+    for (int i = 0; i < 980; ++i) histogram.record(1000000 + i * 100); // 1.0-1.1 ms
+    for (int i = 0; i < 15; ++i) histogram.record(5000000);            // 5 ms
+    for (int i = 0; i < 4; ++i) histogram.record(40000000);            // 40 ms
+    histogram.record(250000000);                                       // One 250 ms stall
+    CHECK(histogram.count() == 1000);
+    CHECK(withinBucket(histogram.percentile(0.5), 1000000 + 499 * 100)); // The 500th sample
+    CHECK(withinBucket(histogram.percentile(0.99), 5000000));            // The 990th to 995th are 5 ms
+    CHECK(withinBucket(histogram.percentile(0.999), 40000000));
+    CHECK(histogram.percentile(1.0) == 250000000);
+    CHECK(histogram.max() == 250000000);
+
+    // A sample anywhere in the 64-bit range reads back within its bucket. The
+    // second, largest possible sample keeps the maximum from capping it.
+    Rng rng(11);
+    for (int i = 0; i < 10000; ++i) {
+        uint64_t value = rng.next() >> rng.range(0, 63);
+        LatencyHistogram pair;
+        pair.record(value);
+        pair.record(~uint64_t(0));
+        CHECK(withinBucket(pair.percentile(0.5), value));
+    }
+    LatencyHistogram extreme;
+    extreme.record(~uint64_t(0));
+    CHECK(extreme.percentile(0.5) == ~uint64_t(0));
+
+    if (checkFailures == 0) std::printf("latency_histogram_test: ok\n");
+    return checkFailures == 0 ? 0 : 1;
+}
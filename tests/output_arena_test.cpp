@@ -0,0 +1,75 @@
+// Every frame the renderer presents must reach the terminal in one write(2),
+// however many cells changed.
+#include "check.h"
+
+// Reads everything written to a pipe on a thread of its own, so a large
+// frame never blocks the writer
+class PipeReader {
+public:
+    PipeReader() {
+        if (pipe(fds) != 0) std::perror("pipe");
+        reader = std::thread([this] {
+            char chunk[4096];
+            ssize_t n;
+            while ((n = read(fds[0], chunk, sizeof(chunk))) > 0) bytes.append(chunk, n);
+        });
+    }
+    // Closes the write end and returns everything that was written
+    std::string finish() {
+        close(fds[1]);
+        reader.join();
+        close(fds[0]);
+        return bytes;
+    }
+    int writeFd() const { return fds[1]; }
+
+private:
+    int fds[2];
+    std::thread reader;
+    std::string bytes;
+};
+
+int main() {
+    GlyphTable glyphs;
+    glyphs.internText("║🍎");
+    glyphs.freeze();
+    const uint16_t apple = glyphs.find("🍎");
+    const uint16_t wall = glyphs.find("║");
+
+    // Much larger than the arena starts out, so composing the first frame has to grow it
+    const int width = 300, height = 120;
+    FrameBuffer frame(glyphs, width, height);
+    OutputArena arena(1024);
+    PipeReader pipe;
+    size_t composedBytes = 0;
+
+    for (int n = 0; n < 5; ++n) {
+        frame.clear();
+        for (int y = 0; y < height; ++y) {
+            frame.put(0, y, wall, 7);
+            frame.put(width - 1, y, wall, 7);
+            for (int x = 1 + n % 2; x + 2 < width; x += 4) frame.put(x, y, apple, static_cast<uint8_t>((x + y + n) % 8));
+        }
+        frame.putText(2, 0, "Score: " + std::to_string(n * 10), 3);
+        size_t bytes = frame.present(arena);
+        CHECK(bytes > 0);
+        CHECK(arena.size() == bytes);
+        composedBytes += bytes;
+        CHECK(arena.flush(pipe.writeFd()) == 1);
+        CHECK(arena.size() == 0);
+    }
+    CHECK(arena.totalWriteCalls() == 5);
+
+    // A frame identical to the last one costs no bytes, and an empty arena no write
+    CHECK(frame.present(arena) == 0);
+    CHECK(arena.flush(pipe.writeFd()) == 0);
+    CHECK(arena.totalWriteCalls() == 5);
+
+    std::string written = pipe.finish();
+    CHECK(written.size() == composedBytes);
+    CHECK(written.find("\033[H\033[2J") < 16); // The first frame starts from a cleared screen
+    CHECK(written.find("Score: 0") != std::string::npos);
+
+    if (checkFailures == 0) std::printf("output_arena_test: ok\n");
+    return checkFailures == 0 ? 0 : 1;
+}
@@ -0,0 +1,53 @@
+// Every particle kernel this CPU supports must leave the particle system
+// exactly as the scalar one does, including the order compaction leaves the
+// survivors in.
+#include "check.h"
+
+// Random particles, some starting off the playfield, each tagged with its
+// starting index in the glyph array so the survivors' order can be compared
+ParticleSystem randomParticles(int n, uint64_t seed) {
+    ParticleSystem particles(n);
+    Rng rng(seed);
+    int first = particles.emit(0, 0, '*', 7, PARTICLE_LIFETIME_STEPS, n);
+    for (int i = first; i < particles.size(); ++i) {
+        particles.x[i] = static_cast<int16_t>(rng.range(-3, 60));
+        particles.y[i] = static_cast<int16_t>(rng.range(-3, 30));
+        particles.velocityX[i] = rng.range(-4, 4) * 0.5f;
+        particles.velocityY[i] = rng.range(-4, 4) * 0.5f;
+        particles.stepsLeft[i] = static_cast<uint8_t>(rng.range(1, PARTICLE_LIFETIME_STEPS));
+        particles.glyph[i] = static_cast<uint16_t>(i);
+    }
+    return particles;
+}
+
+int main() {
+    const int width = 50, height = 25;
+    const auto kernels = particleKernels();
+    int compared = 0;
+    for (int n : {0, 1, 7, 8, 9, 15, 16, 17, 31, 33, 63, 64, 65, 127, 1000, 12345}) {
+        for (const auto& kernel : kernels) {
+            if (!kernel.supported) continue;
+            ParticleSystem expected = randomParticles(n, n + 1);
+            ParticleSystem actual = randomParticles(n, n + 1);
+            for (int step = 0; step < PARTICLE_LIFETIME_STEPS; ++step) {
+                expected.update(width, height, stepParticlesScalar);
+                actual.update(width, height, kernel.step);
+                CHECK(actual.size() == expected.size());
+                bool same = actual.size() == expected.size();
+                for (int i = 0; same && i < expected.size(); ++i) {
+                    same = actual.x[i] == expected.x[i] && actual.y[i] == expected.y[i] &&
+                           actual.stepsLeft[i] == expected.stepsLeft[i] && actual.glyph[i] == expected.glyph[i];
+                }
+                if (!same) std::fprintf(stderr, "kernel %s differs from scalar for %d particles at step %d\n", kernel.name, n, step);
+                CHECK(same);
+            }
+            // Particles live PARTICLE_LIFETIME_STEPS at most
+            CHECK(actual.size() == 0);
+            compared++;
+        }
+    }
+    CHECK(compared > 0);
+
+    if (checkFailures == 0) std::printf("particle_kernels_test: ok (%s active)\n", ACTIVE_PARTICLE_KERNEL.name);
+    return checkFailures == 0 ? 0 : 1;
+}
@@ -0,0 +1,139 @@
+// Replay files: a file saveReplay wrote loads back as it was and plays out
+// to the recorded outcome, and one the game could not be set up from is
+// turned down rather than played.
+#include "check.h"
+
+// A file of its own in /tmp, removed when the test is done
+class TempFile {
+public:
+    TempFile() {
+        char name[] = "/tmp/fruit-replay-XXXXXX";
+        int fd = mkstemp(name);
+        if (fd >= 0) close(fd);
+        path = name;
+    }
+    ~TempFile() { std::remove(path.c_str()); }
+
+    void write(const std::string& text) const { std::ofstream(path) << text; }
+    std::string read() const {
+        std::ostringstream text;
+        text << std::ifstream(path).rdbuf();
+        return text.str();
+    }
+
+    std::string path;
+};
+
+// text with the first occurrence of from replaced by to
+std::string replaced(std::string text, const std::string& from, const std::string& to) {
+    size_t at = text.find(from);
+    if (at == std::string::npos) {
+        std::fprintf(stderr, "no \"%s\" in the replay text\n", from.c_str());
+        checkFailures++;
+        return text;
+    }
+    return text.replace(at, from.size(), to);
+}
+
+// A game driven by random basket moves, pauses and two resizes, with the
+// outcome it was played to. Events are in tick order, as a recording is.
+Replay recordedGame(uint64_t seed) {
+    Replay replay;
+    replay.seed = seed;
+    replay.tickRate = 90;
+    replay.width = 100;
+    replay.height = 25;
+    replay.difficulty = 1;
+    Rng rng(seed);
+    for (uint64_t tick = 1; tick < 20000; tick += rng.range(1, 12)) {
+        if (rng.chance(1)) {
+            replay.events.push_back({tick, 'p', 0, 0});
+            replay.events.push_back({tick, 'p', 0, 0});
+        }
+        replay.events.push_back({tick, rng.chance(50) ? 'a' : 'd', 0, 0});
+    }
+    replay.events.insert(replay.events.begin() + 50, {replay.events[50].tick, 'r', 60, 18});
+    replay.events.insert(replay.events.begin() + 120, {replay.events[120].tick, 'r', 140, 40});
+    replay.outcome.ticks = static_cast<uint64_t>(HEADLESS_MAX_GAME_SECONDS) * replay.tickRate;
+    Game game(true);
+    replay.outcome = game.playReplay(replay, true);
+    return replay;
+}
+
+int main() {
+    Replay replay;
+    replay.seed = 42;
+    replay.tickRate = 120;
+    replay.width = 100;
+    replay.height = 25;
+    replay.difficulty = 2;
+    replay.events = {{3, 'a', 0, 0}, {10, 'r', 60, 18}, {10, 'd', 0, 0}, {250, 'q', 0, 0}};
+    replay.outcome = {250, 40, 1, 4, 2, 4, 0, 1, 3, 1};
+
+    TempFile file;
+    CHECK(saveReplay(file.path, replay));
+    Replay loaded;
+    CHECK(loadReplay(file.path, loaded));
+    CHECK(loaded.seed == replay.seed);
+    CHECK(loaded.tickRate == replay.tickRate);
+    CHECK(loaded.width == replay.width && loaded.height == replay.height);
+    CHECK(loaded.difficulty == replay.difficulty);
+    CHECK(loaded.events.size() == replay.events.size());
+    for (size_t i = 0; i < std::min(loaded.events.size(), replay.events.size()); ++i) {
+        CHECK(loaded.events[i].tick == replay.events[i].tick);
+        CHECK(loaded.events[i].key == replay.events[i].key);
+        if (replay.events[i].key == 'r') CHECK(loaded.events[i].width == 60 && loaded.events[i].height == 18);
+    }
+    CHECK(loaded.outcome == replay.outcome);
+
+    const std::string good = file.read();
+    const std::vector<std::pair<std::string, std::string>> malformed = {
+        {"fruity-replay " + std::to_string(REPLAY_VERSION), "fruity-replay " + std::to_string(REPLAY_VERSION - 1)},
+        {"fruity-replay", "fruity-reply"},
+        {"tick_rate 120", "tick_rate 0"},
+        {"tick_rate 120", "tick_rate " + std::to_string(MAX_TICK_RATE + 1)},
+        {"tick_rate 120", "tick_rate 99999999999"},
+        {"width 100", "width 0"},
+        {"width 100", "width " + std::to_string(MIN_SCREEN_WIDTH - 1)},
+        {"width 100", "width " + std::to_string(MAX_SCREEN_WIDTH + 1)},
+        {"width 100 height 25", "width 5 height 3"},
+        {"height 25", "height " + std::to_string(MIN_SCREEN_HEIGHT - 1)},
+        {"height 25", "height " + std::to_string(MAX_SCREEN_HEIGHT + 1)},
+        {"difficulty 2", "difficulty " + std::to_string(DIFFICULTY_LEVELS.size())},
+        {"difficulty 2", "difficulty -1"},
+        {"r60x18", "r0x0"},
+        {"r60x18", "r60x3"},
+        {"r60x18", "r5000x18"},
+        {"r60x18", "r60-18"},
+        {"3a", "3z"},
+        {"events 4", "events 5"},
+        {"outcome ticks 250", "outcome ticks"},
+    };
+    for (const auto& [from, to] : malformed) {
+        file.write(replaced(good, from, to));
+        bool accepted = loadReplay(file.path, loaded);
+        if (accepted) std::fprintf(stderr, "accepted a replay with \"%s\" in place of \"%s\"\n", to.c_str(), from.c_str());
+        CHECK(!accepted);
+    }
+    CHECK(!loadReplay("/nonexistent/replay", loaded));
+
+    // Saved, loaded and played again, a game ends exactly as it was recorded
+    for (uint64_t seed : {3, 1234567}) {
+        Replay recorded = recordedGame(seed);
+        CHECK(recorded.outcome.ticks > 0);
+        CHECK(saveReplay(file.path, recorded));
+        Replay reloaded;
+        CHECK(loadReplay(file.path, reloaded));
+        CHECK(reloaded.events.size() == recorded.events.size());
+        Game game(true);
+        CHECK(game.playReplay(reloaded, true) == recorded.outcome);
+        // The inputs matter: without them the same seed ends differently
+        reloaded.events.clear();
+        reloaded.outcome.ticks = static_cast<uint64_t>(HEADLESS_MAX_GAME_SECONDS) * reloaded.tickRate;
+        Game idle(true);
+        CHECK(idle.playReplay(reloaded, true) != recorded.outcome);
+    }
+
+    if (checkFailures == 0) std::printf("replay_test: ok\n");
+    return checkFailures == 0 ? 0 : 1;
+}
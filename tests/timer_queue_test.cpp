@@ -0,0 +1,69 @@
+// TimerQueue fires timers by deadline, ties in the order they were
+// scheduled, skips cancelled ones and lets a callback schedule the next.
+#include "check.h"
+
+int main() {
+    using std::chrono::seconds;
+    const SimClock::time_point start{};
+    TimerQueue timers;
+    std::string fired;
+
+    // Scheduled out of order; "b" and "c" share a deadline
+    timers.schedule(start + seconds(3), [&] { fired += 'd'; });
+    timers.schedule(start + seconds(1), [&] { fired += 'a'; });
+    timers.schedule(start + seconds(2), [&] { fired += 'b'; });
+    timers.schedule(start + seconds(2), [&] { fired += 'c'; });
+    timers.runDue(start);
+    CHECK(fired.empty());
+    timers.runDue(start + seconds(2));
+    CHECK(fired == "abc");
+    timers.runDue(start + seconds(2)); // Each timer fires once
+    CHECK(fired == "abc");
+    timers.runDue(start + seconds(10));
+    CHECK(fired == "abcd");
+
+    // Cancelling by handle drops only that timer, and again is harmless
+    fired.clear();
+    timers.schedule(start + seconds(11), [&] { fired += 'e'; });
+    TimerQueue::Id cancelled = timers.schedule(start + seconds(11), [&] { fired += 'x'; });
+    timers.schedule(start + seconds(12), [&] { fired += 'f'; });
+    timers.cancel(cancelled);
+    timers.cancel(cancelled);
+    timers.runDue(start + seconds(12));
+    CHECK(fired == "ef");
+
+    // A callback that re-arms itself: a new deadline already due fires in the
+    // same call, one in the future waits for a later one
+    fired.clear();
+    int repeats = 0;
+    std::function<void()> repeat = [&] {
+        fired += 'r';
+        if (++repeats < 3) timers.schedule(start + seconds(20 + repeats), repeat);
+    };
+    timers.schedule(start + seconds(20), repeat);
+    timers.runDue(start + seconds(21));
+    CHECK(fired == "rr");
+    timers.runDue(start + seconds(22));
+    CHECK(fired == "rrr");
+    timers.runDue(start + seconds(100));
+    CHECK(repeats == 3);
+
+    // A cancelled handle is not reused by the next timer
+    fired.clear();
+    TimerQueue::Id old = timers.schedule(start + seconds(200), [&] { fired += 'y'; });
+    timers.cancel(old);
+    TimerQueue::Id fresh = timers.schedule(start + seconds(200), [&] { fired += 'g'; });
+    CHECK(fresh != old);
+    timers.cancel(old);
+    timers.runDue(start + seconds(200));
+    CHECK(fired == "g");
+
+    // clear() drops everything pending
+    timers.schedule(start + seconds(300), [&] { fired += 'z'; });
+    timers.clear();
+    timers.runDue(start + seconds(300));
+    CHECK(fired == "g");
+
+    if (checkFailures == 0) std::printf("timer_queue_test: ok\n");
+    return checkFailures == 0 ? 0 : 1;
+}